@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdio>
+#include <set>
+#include <string>
+
+#include "btree.hpp"
+#include "alloc_counter.hpp"
+
+/* Usage: btree_alloc_bench [num_keys]
+ *
+ * Counts calls to the global allocator while building a tree, and times the
+ * teardown, for BTree (with its node pool) and std::set. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Set, typename Key>
+static void bench(const char* name, size_t n, Key (*make_key)(size_t)) {
+    auto set = new Set;
+
+    size_t before = num_allocs;
+    auto start = Clock::now();
+    for (size_t i = 0; i < n; i++)
+        set->insert(make_key((i * 2654435761ul) % n));
+    double build = std::chrono::duration<double>(Clock::now() - start).count();
+    size_t allocs = num_allocs - before;
+
+    start = Clock::now();
+    delete set;
+    double teardown = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("%-24s build %7.3f s, %10zu allocations | teardown %7.3f s\n",
+                name, build, allocs, teardown);
+}
+
+static long make_long(size_t i) { return i; }
+
+static std::string make_string(size_t i) {
+    return "/some/long/shared/path/prefix/" + std::to_string(i);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+
+    bench<BTree<long, 2>>("BTree<long, 2>", n, make_long);
+    bench<BTree<long, 6>>("BTree<long, 6>", n, make_long);
+    bench<std::set<long>>("std::set<long>", n, make_long);
+
+    n /= 4;
+    bench<BTree<std::string, 2>>("BTree<string, 2>", n, make_string);
+    bench<BTree<std::string, 6>>("BTree<string, 6>", n, make_string);
+    bench<std::set<std::string>>("std::set<string>", n, make_string);
+
+    {
+        BTree<long, 2> btree;
+        for (size_t i = 0; i < 1'000'000; i++)
+            btree.insert(i);
+
+        const auto& st = btree.pool.get_stats();
+        std::printf("[*] BTree<long, 2> with 1M keys: %zu nodes in %zu chunks\n",
+                    st.allocations, st.chunks);
+    }
+
+    return 0;
+}
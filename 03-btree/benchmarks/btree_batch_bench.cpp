@@ -0,0 +1,78 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "btree.hpp"
+
+/* Usage: btree_batch_bench [num_keys] [batch_size]
+ *
+ * Compares the per-key cost of insert_batch/find_batch with that of calling
+ * insert/contains once per key, on batches of random keys. */
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<std::vector<int>> make_batches(size_t n, size_t batch_size,
+                                                  unsigned seed) {
+    std::mt19937 g(seed);
+    std::uniform_int_distribution<int> dist(0, 1 << 30);
+    std::vector<std::vector<int>> batches(n / batch_size);
+
+    for (auto& batch : batches)
+        for (size_t i = 0; i < batch_size; i++)
+            batch.push_back(dist(g));
+
+    return batches;
+}
+
+template<typename Func>
+static double ns_per_key(size_t n, Func&& func) {
+    auto start = Clock::now();
+    func();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 4'000'000;
+    size_t batch_size = argc > 2 ? std::stoul(argv[2]) : 4096;
+
+    auto inserts = make_batches(n, batch_size, 0);
+    auto lookups = make_batches(n, batch_size, 1);
+    size_t total = (n / batch_size) * batch_size;
+    size_t hits = 0;
+
+    BTree<int> single, batched;
+
+    double single_insert = ns_per_key(total, [&] {
+        for (const auto& batch : inserts)
+            for (auto x : batch)
+                single.insert(x);
+    });
+
+    double batch_insert = ns_per_key(total, [&] {
+        for (const auto& batch : inserts)
+            batched.insert_batch(batch);
+    });
+
+    double single_find = ns_per_key(total, [&] {
+        for (const auto& batch : lookups)
+            for (auto x : batch)
+                hits += single.contains(x);
+    });
+
+    double batch_find = ns_per_key(total, [&] {
+        for (const auto& batch : lookups)
+            for (bool found : batched.find_batch(batch))
+                hits += found;
+    });
+
+    std::printf("[*] keys: %zu, batch size: %zu (hits: %zu)\n",
+                total, batch_size, hits);
+    std::printf("insert        %8.1f ns/key\n", single_insert);
+    std::printf("insert_batch  %8.1f ns/key\n", batch_insert);
+    std::printf("contains      %8.1f ns/key\n", single_find);
+    std::printf("find_batch    %8.1f ns/key\n", batch_find);
+
+    return 0;
+}
@@ -0,0 +1,89 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "btree.hpp"
+
+/* Usage: btree_churn_bench [num_keys] [num_ops]
+ *
+ * Fills a tree with num_keys random keys, then runs num_ops operations that
+ * are half inserts and half deletes of random keys, so the size stays about
+ * the same. Compares BTree at a few orders with std::set. */
+
+using Clock = std::chrono::steady_clock;
+
+struct ChurnOp {
+    bool insert;
+    int key;
+};
+
+static std::vector<ChurnOp> make_ops(size_t n, int max_key, unsigned seed) {
+    std::mt19937 g(seed);
+    std::uniform_int_distribution<int> keys(0, max_key);
+    std::bernoulli_distribution coin(0.5);
+    std::vector<ChurnOp> ops(n);
+
+    for (auto& op : ops)
+        op = { coin(g), keys(g) };
+
+    return ops;
+}
+
+template<typename Tree, typename Insert, typename Remove>
+static void run(const char* name, const std::vector<int>& initial,
+                const std::vector<ChurnOp>& ops, Insert&& insert,
+                Remove&& remove) {
+    Tree tree;
+    size_t hits = 0;
+
+    for (auto x : initial)
+        insert(tree, x);
+
+    auto start = Clock::now();
+    for (const auto& op : ops)
+        hits += op.insert ? insert(tree, op.key) : remove(tree, op.key);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    printf("%-16s %8.1f ns/op %12.0f ops/s  (%zu hits)\n",
+           name, ns / ops.size(), ops.size() / ns * 1e9, hits);
+}
+
+template<size_t B>
+static void run_btree(const char* name, const std::vector<int>& initial,
+                      const std::vector<ChurnOp>& ops) {
+    run<BTree<int, B>>(name, initial, ops,
+        [](BTree<int, B>& t, int x) { return t.insert(x); },
+        [](BTree<int, B>& t, int x) { return t.remove(x); });
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    size_t num_ops = argc > 2 ? std::stoul(argv[2]) : 4'000'000;
+
+    /* Keys are drawn from twice the initial size, so about half of the
+       operations hit */
+    int max_key = 2 * n;
+    std::vector<int> initial;
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> keys(0, max_key);
+    for (size_t i = 0; i < n; i++)
+        initial.push_back(keys(g));
+
+    auto ops = make_ops(num_ops, max_key, 1);
+
+    printf("%zu keys, %zu ops (50%% insert / 50%% delete)\n", n, num_ops);
+
+    run_btree<2>("BTree<int, 2>", initial, ops);
+    run_btree<6>("BTree<int, 6>", initial, ops);
+    run_btree<16>("BTree<int, 16>", initial, ops);
+    run_btree<64>("BTree<int, 64>", initial, ops);
+
+    run<std::set<int>>("std::set<int>", initial, ops,
+        [](std::set<int>& t, int x) { return t.insert(x).second; },
+        [](std::set<int>& t, int x) { return t.erase(x) == 1; });
+
+    return 0;
+}
@@ -0,0 +1,53 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "btree.hpp"
+
+/* Usage: btree_format_bench [num_keys]
+ *
+ * Times dumping the shape of a tree level by level. The baseline formats
+ * every level with format_level, which walks the tree from the root once per
+ * level. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Func>
+static void bench(const char* name, Func&& func) {
+    auto start = Clock::now();
+    func();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("%-28s %8.3f s\n", name, secs);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+    BTree<long> btree;
+    std::ofstream null{"/dev/null"};
+
+    for (size_t i = 0; i < n; i++)
+        btree.insert((i * 2654435761ul) % n);
+
+    auto depth = btree.depth().value();
+
+    bench("format_level per level", [&] {
+        for (size_t i = 0; i <= depth; i++)
+            null << btree.root->format_level(i) << '\n';
+    });
+
+    bench("write_levels (one BFS)", [&] { btree.write_levels(null); });
+
+    BTreeStats st;
+    bench("stats (one BFS)", [&] { st = btree.stats(); });
+
+    std::printf("[*] keys: %zu, nodes: %zu, depth: %zu\n",
+                st.num_keys, st.num_nodes, st.depth);
+    for (size_t lv = 0; lv < st.levels.size(); lv++)
+        std::printf("    level %zu: %10zu nodes %12zu keys, fill %.3f\n", lv,
+                    st.levels[lv].num_nodes, st.levels[lv].num_keys,
+                    st.levels[lv].fill_factor());
+
+    return 0;
+}
@@ -0,0 +1,70 @@
+#include <chrono>
+#include <cstdio>
+#include <functional>
+#include <string>
+
+#include "btree.hpp"
+
+/* Usage: btree_scan_bench [num_keys]
+ *
+ * Full in-order scans of a B-tree, summing the keys. The std::function
+ * baseline reproduces the former BTreeNode::for_all, which took the visitor
+ * by value at every level of the recursion. Pass 100000000 to scan 100M
+ * keys (about 0.5 GiB of nodes). */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename T, size_t B>
+static void for_all_by_value(BTreeNode<T, B>* node, std::function<void(T&)> func) {
+    if (node->type == NodeType::LEAF) {
+        for (size_t j = 0; j < node->n; j++)
+            func(node->keys[j]);
+        return;
+    }
+
+    for (size_t j = 0; j < node->n; j++) {
+        for_all_by_value(node->edges[j], func);
+        func(node->keys[j]);
+    }
+    for_all_by_value(node->edges[node->n], func);
+}
+
+template<typename Func>
+static void bench(const char* name, size_t n, Func&& func) {
+    auto start = Clock::now();
+    long sum = func();
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+
+    std::printf("%-24s %8.3f s %8.2f ns/key (sum %ld)\n",
+                name, secs, secs * 1e9 / n, sum);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+    BTree<long> btree;
+
+    /* Insert in order: the scan cost does not depend on the insert order */
+    for (size_t i = 0; i < n; i++)
+        btree.insert(i);
+
+    bench("std::function by value", n, [&] {
+        long sum = 0;
+        for_all_by_value<long, 6>(btree.root, [&sum](long& k) { sum += k; });
+        return sum;
+    });
+
+    bench("template for_all", n, [&] {
+        long sum = 0;
+        btree.for_all([&sum](long& k) { sum += k; });
+        return sum;
+    });
+
+    bench("iterator", n, [&] {
+        long sum = 0;
+        for (auto k : btree)
+            sum += k;
+        return sum;
+    });
+
+    return 0;
+}
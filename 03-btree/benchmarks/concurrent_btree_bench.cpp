@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "btree.hpp"
+#include "concurrent_btree.hpp"
+
+/* Usage: concurrent_btree_bench [num_keys] [max_threads]
+ *
+ * Inserts num_keys keys split evenly over 1, 2, 4, ... max_threads threads,
+ * then looks every key up again. The baseline is a BTree behind a single
+ * std::mutex. */
+
+using Clock = std::chrono::steady_clock;
+
+/* Keeps the results of the timed calls alive */
+static std::atomic<size_t> sink{0};
+
+static unsigned long scramble(unsigned long x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdul;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ul;
+    x ^= x >> 33;
+    return x;
+}
+
+struct LockedBTree {
+    BTree<unsigned long> tree;
+    std::mutex lock;
+
+    bool insert(unsigned long k) {
+        std::lock_guard<std::mutex> g(lock);
+        return tree.insert(k);
+    }
+
+    bool contains(unsigned long k) {
+        std::lock_guard<std::mutex> g(lock);
+        return BTreeNode<unsigned long>::search(tree.root, k).first != nullptr;
+    }
+};
+
+template<typename Func>
+static double run_threads(size_t num_threads, size_t n, Func&& func) {
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+
+    for (size_t t = 0; t < num_threads; t++)
+        threads.emplace_back([&func, t, num_threads, n] {
+            size_t hits = 0;
+            for (size_t i = t; i < n; i += num_threads)
+                hits += func(scramble(i));
+            sink += hits;
+        });
+
+    for (auto& th : threads)
+        th.join();
+
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+template<typename Tree>
+static void bench(const char* name, size_t n, size_t num_threads) {
+    Tree tree;
+
+    double ins = run_threads(num_threads, n,
+                             [&tree](unsigned long k) { return tree.insert(k); });
+    double find = run_threads(num_threads, n,
+                              [&tree](unsigned long k) { return tree.contains(k); });
+
+    std::printf("%-16s %3zu threads | insert %8.2f Mops/s | find %8.2f Mops/s\n",
+                name, num_threads, n / ins / 1e6, n / find / 1e6);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 4'000'000;
+    size_t max_threads = argc > 2 ? std::stoul(argv[2]) :
+        std::max(1u, std::thread::hardware_concurrency());
+
+    for (size_t t = 1; t <= max_threads; t *= 2) {
+        bench<LockedBTree>("mutex+BTree", n, t);
+        bench<ConcurrentBTree<unsigned long>>("ConcurrentBTree", n, t);
+    }
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <sys/resource.h>
+
+#include "disk_btree.hpp"
+
+/* Usage: disk_btree_bench [num_keys] [pool_frames] [path]
+ *
+ * To measure a data set bigger than RAM, pick num_keys such that
+ * num_keys * sizeof(long) is well above the physical memory, and keep
+ * pool_frames * PAGE_SIZE small. Keys are generated on the fly, so the
+ * benchmark itself only holds the buffer pool in memory. */
+
+using Clock = std::chrono::steady_clock;
+
+struct Faults {
+    long minor;
+    long major;
+};
+
+static Faults get_faults() {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+    return { ru.ru_minflt, ru.ru_majflt };
+}
+
+template<typename Tree>
+static void report(const char* phase, size_t ops, Clock::time_point start,
+                   const Faults& before, const BufferPoolStats& pool_before,
+                   const Tree& tree) {
+    double secs = std::chrono::duration<double>(Clock::now() - start).count();
+    auto faults = get_faults();
+    const auto& pool = tree.get_pool_stats();
+
+    std::printf("%-8s %10zu ops %8.3f s %10.0f ops/s | pool hit %10zu miss %10zu "
+                "evict %10zu writeback %10zu | minflt %8ld majflt %8ld\n",
+                phase, ops, secs, ops / secs,
+                pool.hits - pool_before.hits,
+                pool.misses - pool_before.misses,
+                pool.evictions - pool_before.evictions,
+                pool.writebacks - pool_before.writebacks,
+                faults.minor - before.minor, faults.major - before.major);
+}
+
+/* A bijection on 64-bit integers, used to insert keys in a random order
+   without materializing a shuffled vector */
+static unsigned long scramble(unsigned long x) {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdul;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ul;
+    x ^= x >> 33;
+    return x;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+    size_t frames = argc > 2 ? std::stoul(argv[2]) : 1024;
+    std::string path = argc > 3 ? argv[3] :
+        (std::filesystem::temp_directory_path() / "disk_btree_bench.db").string();
+
+    std::filesystem::remove(path);
+
+    std::cout << "[*] keys: " << n << ", pool: " << frames << " frames ("
+              << frames * PAGE_SIZE / 1024 << " KiB), file: " << path << '\n';
+
+    {
+        DiskBTree<unsigned long> tree(path, frames);
+
+        auto faults = get_faults();
+        auto pool = tree.get_pool_stats();
+        auto start = Clock::now();
+        for (size_t i = 0; i < n; i++)
+            tree.insert(scramble(i));
+        tree.flush();
+        report("insert", n, start, faults, pool, tree);
+
+        std::mt19937_64 g(0);
+        std::uniform_int_distribution<size_t> dist(0, n - 1);
+        size_t lookups = std::min<size_t>(n, 1'000'000), found = 0;
+
+        faults = get_faults();
+        pool = tree.get_pool_stats();
+        start = Clock::now();
+        for (size_t i = 0; i < lookups; i++)
+            found += tree.find(scramble(dist(g)));
+        report("find", lookups, start, faults, pool, tree);
+
+        size_t scanned = 0;
+        faults = get_faults();
+        pool = tree.get_pool_stats();
+        start = Clock::now();
+        tree.scan(0, ~0ul / 16, [&scanned](const unsigned long&) { scanned++; });
+        report("scan", scanned, start, faults, pool, tree);
+
+        std::cout << "[*] found " << found << '/' << lookups
+                  << ", depth " << tree.depth().value_or(0)
+                  << ", file size "
+                  << std::filesystem::file_size(path) / (1024 * 1024) << " MiB\n";
+    }
+
+    std::filesystem::remove(path);
+
+    return 0;
+}
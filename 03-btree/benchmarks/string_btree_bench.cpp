@@ -0,0 +1,94 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "btree.hpp"
+#include "string_btree.hpp"
+#include "alloc_counter.hpp"
+
+/* Usage: string_btree_bench [num_urls]
+ *
+ * Memory per key and lookup latency on synthetic URLs that share long
+ * prefixes, for StringBTree, BTree<std::string> and std::set<std::string>.
+ * Memory is the growth of live heap bytes while building the set. */
+
+using Clock = std::chrono::steady_clock;
+
+static std::vector<std::string> make_urls(size_t n, unsigned seed) {
+    static const char* hosts[] = {
+        "https://www.example.com/",
+        "https://static.cdn.example.net/assets/",
+        "https://docs.example.org/reference/latest/api/",
+        "https://shop.example.com/products/catalog/",
+    };
+    std::mt19937 g(seed);
+    std::uniform_int_distribution<int> dist(0, 1 << 20);
+    std::vector<std::string> urls;
+
+    for (size_t i = 0; i < n; i++) {
+        std::string url = hosts[dist(g) % 4];
+        url += "section-" + std::to_string(dist(g) % 64) + '/';
+        url += "page-" + std::to_string(dist(g)) + ".html";
+        if (dist(g) % 3 == 0)
+            url += "?utm_source=newsletter&utm_medium=email";
+        urls.push_back(std::move(url));
+    }
+
+    return urls;
+}
+
+template<typename Set, typename Contains>
+static void bench(const char* name, const std::vector<std::string>& urls,
+                  const std::vector<std::string>& queries, Contains contains) {
+    long before = live_bytes;
+    auto set = new Set;
+
+    for (const auto& url : urls)
+        set->insert(url);
+
+    double bytes_per_key = (double)(live_bytes - before) / urls.size();
+
+    size_t hits = 0;
+    auto start = Clock::now();
+    for (const auto& q : queries)
+        hits += contains(*set, q);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    std::printf("%-22s %8.1f bytes/key %8.1f ns/lookup (hits %zu)\n",
+                name, bytes_per_key, ns / queries.size(), hits);
+
+    delete set;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 2'000'000;
+    auto urls = make_urls(n, 0);
+    auto queries = make_urls(n / 2, 1);
+
+    /* Half of the queries hit */
+    queries.insert(queries.end(), urls.begin(), urls.begin() + n / 2);
+    std::shuffle(queries.begin(), queries.end(), std::mt19937{2});
+
+    size_t total = 0;
+    for (const auto& url : urls)
+        total += url.size();
+    std::printf("[*] %zu URLs, %.1f bytes on average\n", n, (double)total / n);
+
+    bench<StringBTree<16>>("StringBTree<16>", urls, queries,
+                           [](const auto& s, const std::string& k) {
+                               return s.contains(k);
+                           });
+    bench<BTree<std::string, 16>>("BTree<string, 16>", urls, queries,
+                                  [](const auto& s, const std::string& k) {
+                                      return s.contains(k);
+                                  });
+    bench<std::set<std::string>>("std::set<string>", urls, queries,
+                                 [](const auto& s, const std::string& k) {
+                                     return s.count(k) == 1;
+                                 });
+
+    return 0;
+}
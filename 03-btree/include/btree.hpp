@@ -1,3 +1,6 @@
+#ifndef __BTREE_H_
+#define __BTREE_H_
+
 #include <cstddef>
 #include <array>
 #include <iostream>
@@ -8,27 +11,80 @@
 #include <string>
 #include <sstream>
 #include <functional>
+#include <vector>
+#include <utility>
+#include <memory>
+#include <new>
+#include <type_traits>
 
 enum class NodeType { LEAF, INTERNAL };
 
 template<typename T, size_t B = 6>
 struct BTreeNode;
 
+template<typename T, size_t B = 6>
+struct BTreeIterator;
+
+template<typename T, size_t B = 6>
+class BTreeNodePool;
+
+/* Shape of one level of a B-tree. Level 0 is the root. */
+struct BTreeLevelStats {
+    size_t num_nodes = 0;
+    size_t num_keys = 0;
+    size_t capacity = 0;        /* num_nodes * (2B - 1) */
+
+    double fill_factor() const {
+        return capacity ? (double)num_keys / capacity : 0.0;
+    }
+};
+
+struct BTreeStats {
+    size_t depth = 0;
+    size_t num_nodes = 0;
+    size_t num_keys = 0;
+    std::vector<BTreeLevelStats> levels;
+};
+
 template<typename T, size_t B = 6>
 struct BTree {
     BTreeNode<T, B>* root = nullptr;
+    BTreeNodePool<T, B> pool;
+
+    ~BTree() { clear(); }
 
-    ~BTree() { if (root) delete root; }
+    /* Drop all the keys. The node memory is released in bulk. */
+    void clear();
 
     bool insert(const T&);
     bool remove(const T&);
+    bool contains(const T&) const;
 
-    void for_all(std::function<void(T&)>);
-    void for_all_nodes(std::function<void(const BTreeNode<T,B>&)>);
+    /* Sort the keys once, and share root-to-leaf traversals among the keys
+       that land in the same subtree. */
+    size_t insert_batch(std::vector<T>);
+    std::vector<bool> find_batch(const std::vector<T>&) const;
+
+    template<typename F>
+    void for_all(F&& func);
+    template<typename F>
+    void for_all_nodes(F&& func);
+
+    /* In-order iteration over the keys */
+    BTreeIterator<T, B> begin() const;
+    BTreeIterator<T, B> end() const { return BTreeIterator<T, B>{}; }
 
     const std::optional<T> find_rightmost_key() const;
     const std::optional<size_t> depth() const;
 
+    /* Breadth-first traversal in a single pass. `func(level, nodes)` is
+       called once per level, from the root down. */
+    template<typename F>
+    void for_each_level(F&& func) const;
+
+    void write_levels(std::ostream&) const;
+    BTreeStats stats() const;
+
     std::string format(void);
 };
 
@@ -46,25 +102,33 @@ struct BTreeNode {
     template<typename InputIt>
     BTreeNode(InputIt begin, InputIt end);
 
-    ~BTreeNode();
-
-    bool insert(const T& t);
-    size_t get_index(const T& t);
+    bool insert(const T& t, BTreeNodePool<T, B>&);
+    size_t get_index(const T& t) const;
 
-    void for_all(std::function<void(T&)> func);
+    template<typename F>
+    void for_all(F& func);
 
-    bool remove(const T& t);
+    bool remove(const T& t, BTreeNodePool<T, B>&);
 
     size_t depth(void);
     std::string format_subtree(size_t);
     std::string format_level(size_t);
     std::string format_node(void);
+    void write_node(std::ostream&) const;
     std::vector<BTreeNode<T, B>*> find_nodes_at_level(size_t);
 
-    void for_all_nodes(std::function<void(const BTreeNode&)>);
+    template<typename F>
+    void for_all_nodes(F& func);
 
     static std::pair<BTreeNode*, size_t> search(BTreeNode<T, B>*, const T& t);
-    static void split_child(BTreeNode<T, B>&, size_t);
+    static void split_child(BTreeNodePool<T, B>&, BTreeNode<T, B>&, size_t);
+
+    template<typename It>
+    static It insert_sorted(BTreeNodePool<T, B>&, BTreeNode<T, B>&, It, It,
+                            size_t&);
+    static void find_sorted(const BTreeNode<T, B>&, const size_t*,
+                            const size_t*, const std::vector<T>&,
+                            std::vector<bool>&);
     static bool try_borrow_from_sibling(BTreeNode<T, B>&, size_t);
     static bool borrow_from_right(BTreeNode<T, B>&, size_t);
     static bool borrow_from_left(BTreeNode<T, B>&, size_t);
@@ -72,49 +136,138 @@ struct BTreeNode {
     /* NOTE: If the root node has only one key, it will be empty after
       merging the children. Take care of updating the root. I guess this is
       the only way a B-tree may shrink its height. */
-    static bool merge_children(BTreeNode<T, B>&, size_t);
+    static bool merge_children(BTreeNodePool<T, B>&, BTreeNode<T, B>&, size_t);
 
     static T& find_rightmost_key(BTreeNode<T, B>&);
 };
 
+/**
+ * In-order iterator with an explicit stack of (node, index) pairs, one per
+ * level. The top of the stack is the current key; in the entries below it,
+ * `index` is the key to visit once the subtree left of it is exhausted.
+ * An empty stack is the end.
+ */
+template<typename T, size_t B>
+struct BTreeIterator {
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    std::vector<std::pair<const BTreeNode<T, B>*, size_t>> stack;
+
+    BTreeIterator() = default;
+    explicit BTreeIterator(const BTreeNode<T, B>* root);
+
+    reference operator*() const { return stack.back().first->keys[stack.back().second]; }
+    pointer operator->() const { return &**this; }
+
+    BTreeIterator& operator++();
+    BTreeIterator operator++(int) { auto it = *this; ++*this; return it; }
+
+    bool operator==(const BTreeIterator& other) const;
+    bool operator!=(const BTreeIterator& other) const { return !(*this == other); }
+
+private:
+    void push_leftmost(const BTreeNode<T, B>*);
+};
+
+struct BTreeNodePoolStats {
+    size_t allocations = 0;     /* Nodes handed out */
+    size_t reuses = 0;          /* ... of which came from the free list */
+    size_t releases = 0;
+    size_t chunks = 0;          /* Calls to the global allocator */
+    size_t capacity = 0;        /* Node slots in all chunks */
+};
+
+/**
+ * A per-tree arena of B-tree nodes. Nodes are carved out of chunks that grow
+ * geometrically, and released nodes are kept on a free list for the next
+ * split. The chunks are only returned to the global allocator all at once,
+ * when the pool is reset or destroyed.
+ *
+ * The pool does not know which of its slots are live, so it never runs node
+ * destructors by itself: the owner destroys the live nodes before reset()
+ * when T is not trivially destructible.
+ */
+template<typename T, size_t B>
+class BTreeNodePool {
+public:
+    BTreeNodePool() = default;
+
+    template<typename... Args>
+    BTreeNode<T, B>* allocate(Args&&... args);
+    void release(BTreeNode<T, B>*);
+    void reset();
+
+    const BTreeNodePoolStats& get_stats() const { return stats; }
+
+private:
+    static constexpr size_t MIN_CHUNK_NODES = 32;
+    static constexpr size_t MAX_CHUNK_NODES = 1 << 14;
+
+    union Slot {
+        Slot* next;
+        alignas(BTreeNode<T, B>) unsigned char node[sizeof(BTreeNode<T, B>)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    Slot* free_list = nullptr;
+    Slot* bump = nullptr;       /* Next never-used slot of the last chunk */
+    Slot* bump_end = nullptr;
+    BTreeNodePoolStats stats;
+
+    BTreeNodePool(const BTreeNodePool&);
+    BTreeNodePool& operator=(const BTreeNodePool&);
+};
+
 template<typename T,  size_t B>
 bool BTree<T, B>::insert(const T& t) {
     if (!root) {
-        root = new BTreeNode<T, B>(t);
+        root = pool.allocate(t);
         return true;
     }
 
     /* Make sure the root node is not full. Create an empty tree which has
        the original root as a child. Then split the original root. */
     if (root->n >= 2 * B - 1) {
-        BTreeNode<T, B>* new_root = new BTreeNode<T, B>{};
+        BTreeNode<T, B>* new_root = pool.allocate();
         new_root->edges[0] = root;
 		new_root->type = NodeType::INTERNAL;
-        BTreeNode<T, B>::split_child(*new_root, 0);
+        BTreeNode<T, B>::split_child(pool, *new_root, 0);
         root = new_root;
 		// root->type = NodeType::INTERNAL;
     }
 
-    return root->insert(t);
+    return root->insert(t, pool);
 }
 
 /* By default, use in-order traversal */
 template<typename T, size_t B>
-void BTree<T, B>::for_all(std::function<void(T&)> func) {
+template<typename F>
+void BTree<T, B>::for_all(F&& func) {
     if (root)
         root->for_all(func);
 }
 
 /* This isn't necessarily the in-order traversal */
 template<typename T, size_t B>
-void BTree<T, B>::for_all_nodes(std::function<void(const BTreeNode<T,B>&)> func) {
+template<typename F>
+void BTree<T, B>::for_all_nodes(F&& func) {
     if (root)
         root->for_all_nodes(func);
 }
 
+template<typename T, size_t B>
+BTreeIterator<T, B> BTree<T, B>::begin() const {
+    return BTreeIterator<T, B>{root};
+}
+
 template<typename T, size_t B>
 const std::optional<T> BTree<T, B>::find_rightmost_key() const {
-    if (!root)
+    /* Removing every key leaves the root as an empty leaf */
+    if (!root || root->n == 0)
         return std::nullopt;
 
     return BTreeNode<T, B>::find_rightmost_key(*root);
@@ -129,9 +282,76 @@ const std::optional<size_t> BTree<T, B>::depth() const {
 }
 
 template<typename T, size_t B>
-bool BTreeNode<T, B>::insert(const T& t) {
+bool BTree<T, B>::contains(const T& t) const {
+    const BTreeNode<T, B>* node = root;
+
+    while (node) {
+        size_t idx = node->get_index(t);
+        if (idx < node->n && node->keys[idx] == t)
+            return true;
+        if (node->type == NodeType::LEAF)
+            return false;
+        node = node->edges[idx];
+    }
+
+    return false;
+}
+
+template<typename T, size_t B>
+size_t BTree<T, B>::insert_batch(std::vector<T> ts) {
+    size_t inserted = 0;
+
+    if (ts.empty())
+        return 0;
+
+    std::sort(ts.begin(), ts.end());
+
+    if (!root)
+        root = pool.allocate();
+
+    auto it = ts.begin();
+    while (it != ts.end()) {
+        /* Same as insert(): grow the tree when the root is full */
+        if (root->n >= 2 * B - 1) {
+            BTreeNode<T, B>* new_root = pool.allocate();
+            new_root->edges[0] = root;
+            new_root->type = NodeType::INTERNAL;
+            BTreeNode<T, B>::split_child(pool, *new_root, 0);
+            root = new_root;
+        }
+
+        it = BTreeNode<T, B>::insert_sorted(pool, *root, it, ts.end(),
+                                            inserted);
+    }
+
+    return inserted;
+}
+
+/* The result is in the order of `ts` */
+template<typename T, size_t B>
+std::vector<bool> BTree<T, B>::find_batch(const std::vector<T>& ts) const {
+    std::vector<bool> found(ts.size(), false);
+    std::vector<size_t> order(ts.size());
+
+    if (!root || ts.empty())
+        return found;
+
+    for (size_t i = 0; i < ts.size(); i++)
+        order[i] = i;
+
+    std::sort(order.begin(), order.end(),
+              [&ts](size_t a, size_t b) { return ts[a] < ts[b]; });
+
+    BTreeNode<T, B>::find_sorted(*root, order.data(),
+                                 order.data() + order.size(), ts, found);
+
+    return found;
+}
+
+template<typename T, size_t B>
+bool BTreeNode<T, B>::insert(const T& t, BTreeNodePool<T, B>& pool) {
 	size_t idx = get_index(t);
-	if(idx < 2*B-1 && keys[idx] == t)
+	if(idx < n && keys[idx] == t)
 		return false;
 
 	if(type == NodeType::LEAF) {
@@ -143,12 +363,15 @@ bool BTreeNode<T, B>::insert(const T& t) {
 	}
 
 	if(!edges[idx])
-		edges[idx] = new BTreeNode<T, B>{};
+		edges[idx] = pool.allocate();
 	if(edges[idx]->n >= 2*B-1)
-		split_child(*this, idx);
+		split_child(pool, *this, idx);
 	
+	/* The split may have lifted t itself into this node */
 	idx = get_index(t);
-	return edges[idx]->insert(t);	
+	if(idx < n && keys[idx] == t)
+		return false;
+	return edges[idx]->insert(t, pool);	
 }
 
 /**
@@ -166,7 +389,7 @@ bool BTreeNode<T, B>::insert(const T& t) {
  *     n.get_index(31) = 4
  */
 template<typename T, size_t B>
-size_t BTreeNode<T, B>::get_index(const T& t) {
+size_t BTreeNode<T, B>::get_index(const T& t) const {
 	size_t idx = 0;
 	while(idx < n) {
 		if(t <= keys[idx])
@@ -176,8 +399,11 @@ size_t BTreeNode<T, B>::get_index(const T& t) {
 	return idx;
 }
 
+/* The visitor is passed down by reference, so it is neither copied per node
+   nor hidden behind a type-erased call. */
 template<typename T, size_t B>
-void BTreeNode<T, B>::for_all(std::function<void(T&)> func) {
+template<typename F>
+void BTreeNode<T, B>::for_all(F& func) {
     if (type == NodeType::LEAF) {
         for (auto j = 0; j < n; j++)
             func(keys[j]);
@@ -197,7 +423,8 @@ void BTreeNode<T, B>::for_all(std::function<void(T&)> func) {
 
 /* This isn't necessarily the in-order traversal */
 template<typename T, size_t B>
-void BTreeNode<T, B>::for_all_nodes(std::function<void(const BTreeNode<T,B>&)> func) {
+template<typename F>
+void BTreeNode<T, B>::for_all_nodes(F& func) {
     if (type == NodeType::LEAF) {
         func(*this);
     } else {
@@ -212,14 +439,59 @@ void BTreeNode<T, B>::for_all_nodes(std::function<void(const BTreeNode<T,B>&)> f
     }
 }
 
+template<typename T, size_t B>
+BTreeIterator<T, B>::BTreeIterator(const BTreeNode<T, B>* root) {
+    if (root && root->n > 0)
+        push_leftmost(root);
+}
+
+template<typename T, size_t B>
+void BTreeIterator<T, B>::push_leftmost(const BTreeNode<T, B>* node) {
+    for (;;) {
+        stack.emplace_back(node, 0);
+        if (node->type == NodeType::LEAF)
+            return;
+        node = node->edges[0];
+    }
+}
+
+template<typename T, size_t B>
+BTreeIterator<T, B>& BTreeIterator<T, B>::operator++() {
+    auto& [node, idx] = stack.back();
+
+    /* The common case: the next key is in the same leaf */
+    if (node->type == NodeType::LEAF && ++idx < node->n)
+        return *this;
+
+    if (node->type == NodeType::INTERNAL) {
+        /* Visit the subtree between keys[idx] and keys[idx + 1] first */
+        push_leftmost(node->edges[++idx]);
+        return *this;
+    }
+
+    while (!stack.empty() && stack.back().second == stack.back().first->n)
+        stack.pop_back();
+
+    return *this;
+}
+
+template<typename T, size_t B>
+bool BTreeIterator<T, B>::operator==(const BTreeIterator<T, B>& other) const {
+    if (stack.empty() || other.stack.empty())
+        return stack.empty() == other.stack.empty();
+
+    return stack.back() == other.stack.back();
+}
+
 /* Assume this is called only when the child parent->edges[idx] is full, and
    the parent is not full. */
 template<typename T, size_t B>
-void BTreeNode<T, B>::split_child(BTreeNode<T, B>& parent, size_t idx) {
+void BTreeNode<T, B>::split_child(BTreeNodePool<T, B>& pool,
+                                  BTreeNode<T, B>& parent, size_t idx) {
 	BTreeNode<T, B> *child = parent.edges[idx];
 	T& m = child->keys[B-1];
 
-	BTreeNode<T, B> *new_node = new BTreeNode<T, B>{};
+	BTreeNode<T, B> *new_node = pool.allocate();
 	new_node->type = child->type;
 	child->n = new_node->n = B-1;
 	for(size_t i = 0; i < B-1; i++) {
@@ -238,28 +510,184 @@ void BTreeNode<T, B>::split_child(BTreeNode<T, B>& parent, size_t idx) {
 	parent.n++;
 }
 
+/**
+ * Insert the sorted keys in [first, last) into the subtree of `node`, which
+ * must not be full. Keys that go to the same child are passed down together,
+ * so the path to a leaf is walked once per group instead of once per key.
+ *
+ * A full child is split before stepping into it. When that is impossible
+ * because `node` itself became full, give up and return the first key that
+ * was not inserted: the caller splits `node` and calls again.
+ */
+template<typename T, size_t B>
+template<typename It>
+It BTreeNode<T, B>::insert_sorted(BTreeNodePool<T, B>& pool,
+                                  BTreeNode<T, B>& node, It first, It last,
+                                  size_t& inserted) {
+    while (first != last) {
+        size_t idx = node.get_index(*first);
+
+        if (idx < node.n && node.keys[idx] == *first) {
+            ++first;
+            continue;
+        }
+
+        if (node.type == NodeType::LEAF) {
+            if (node.n >= 2 * B - 1)
+                return first;
+
+            for (size_t i = node.n; i != idx; i--)
+                node.keys[i] = node.keys[i - 1];
+            node.keys[idx] = *first++;
+            node.n++;
+            inserted++;
+            continue;
+        }
+
+        if (node.edges[idx]->n >= 2 * B - 1) {
+            if (node.n >= 2 * B - 1)
+                return first;
+
+            split_child(pool, node, idx);
+            continue;
+        }
+
+        /* All the keys below keys[idx] belong to edges[idx] */
+        It group_last = idx < node.n ?
+            std::lower_bound(first, last, node.keys[idx]) : last;
+        first = insert_sorted(pool, *node.edges[idx], first, group_last,
+                              inserted);
+    }
+
+    return first;
+}
+
+/**
+ * Look up the keys ts[*first], ..., ts[*(last - 1)], which are sorted, in the
+ * subtree of `node`. The children that will be visited are prefetched before
+ * descending into the first of them.
+ */
+template<typename T, size_t B>
+void BTreeNode<T, B>::find_sorted(const BTreeNode<T, B>& node,
+                                  const size_t* first, const size_t* last,
+                                  const std::vector<T>& ts,
+                                  std::vector<bool>& found) {
+    struct Group { const size_t* first; const size_t* last; size_t edge; };
+    std::array<Group, 2 * B> groups;
+    size_t num_groups = 0;
+    size_t idx = 0;
+
+    for (const size_t* it = first; it != last; ++it) {
+        const T& t = ts[*it];
+
+        while (idx < node.n && node.keys[idx] < t)
+            idx++;
+
+        if (idx < node.n && node.keys[idx] == t) {
+            found[*it] = true;
+            continue;
+        }
+
+        if (node.type == NodeType::LEAF)
+            continue;
+
+        /* The keys of one edge are contiguous: a key equal to a separator
+           can only sit before or after them. */
+        if (num_groups > 0 && groups[num_groups - 1].edge == idx) {
+            groups[num_groups - 1].last = it + 1;
+        } else {
+            groups[num_groups++] = { it, it + 1, idx };
+            __builtin_prefetch(node.edges[idx]);
+        }
+    }
+
+    for (size_t g = 0; g < num_groups; g++)
+        find_sorted(*node.edges[groups[g].edge], groups[g].first,
+                    groups[g].last, ts, found);
+}
+
 template<typename T, size_t B>
 bool BTree<T, B>::remove(const T& t) {
     if (!root)
         return false;
 
-    root->remove(t);
+    bool removed = root->remove(t, pool);
 
     /* After merging, the size of the root may become 0. */
     if (root->n == 0 && root->type == NodeType::INTERNAL) {
         auto prev_root = root;
         root = root->edges[0];
-        prev_root->type = NodeType::LEAF;
-        delete prev_root;
+        pool.release(prev_root);
     }
 
-    return true;
+    return removed;
 }
 
+/**
+ * Top-down deletion in a single pass.
+ *
+ * Before stepping into a child, make sure it has at least B keys, by
+ * borrowing a key from a sibling or by merging it with one. The child can
+ * then lose a key without underflowing, so no node is ever revisited on the
+ * way back up.
+ */
 template<typename T, size_t B>
-bool BTreeNode<T, B>::remove(const T& t) {
-    // TODO
-    return false;
+bool BTreeNode<T, B>::remove(const T& t, BTreeNodePool<T, B>& pool) {
+    BTreeNode<T, B>* node = this;
+    T key = t;
+
+    for (;;) {
+        size_t idx = node->get_index(key);
+        bool found = idx < node->n && node->keys[idx] == key;
+
+        if (node->type == NodeType::LEAF) {
+            if (!found)
+                return false;
+
+            std::move(node->keys.begin() + idx + 1,
+                      node->keys.begin() + node->n,
+                      node->keys.begin() + idx);
+            node->n--;
+            return true;
+        }
+
+        if (found) {
+            BTreeNode<T, B>* left = node->edges[idx];
+            BTreeNode<T, B>* right = node->edges[idx + 1];
+
+            if (left->n >= B) {
+                /* Replace the key with its predecessor, and remove that
+                   from the left subtree instead */
+                key = find_rightmost_key(*left);
+                node->keys[idx] = key;
+                node = left;
+            } else if (right->n >= B) {
+                BTreeNode<T, B>* leftmost = right;
+                while (leftmost->type == NodeType::INTERNAL)
+                    leftmost = leftmost->edges[0];
+
+                key = leftmost->keys[0];
+                node->keys[idx] = key;
+                node = right;
+            } else {
+                /* Both have B-1 keys: the key moves down into the merged
+                   node, and is removed from there */
+                merge_children(pool, *node, idx);
+                node = left;
+            }
+            continue;
+        }
+
+        if (node->edges[idx]->n < B && !try_borrow_from_sibling(*node, idx)) {
+            /* Merge with the right sibling, or the left one for the last
+               edge */
+            if (idx == node->n)
+                idx--;
+            merge_children(pool, *node, idx);
+        }
+
+        node = node->edges[idx];
+    }
 }
 
 /**
@@ -270,26 +698,85 @@ bool BTreeNode<T, B>::remove(const T& t) {
  */
 template<typename T, size_t B>
 bool BTreeNode<T, B>::try_borrow_from_sibling(BTreeNode<T, B>&node, size_t e) {
-    // TODO
+    if (e > 0 && node.edges[e - 1]->n >= B)
+        return borrow_from_left(node, e);
+
+    if (e < node.n && node.edges[e + 1]->n >= B)
+        return borrow_from_right(node, e);
+
     return false;
 }
 
+/* Rotate the separator node.keys[edge] down into the child, and the first
+   key of the right sibling up into its place. */
 template<typename T, size_t B>
 bool BTreeNode<T, B>::borrow_from_right(BTreeNode<T, B>& node, size_t edge) {
-    // TODO
-    return false;
+    BTreeNode<T, B>* child = node.edges[edge];
+    BTreeNode<T, B>* right = node.edges[edge + 1];
+
+    child->keys[child->n] = std::move(node.keys[edge]);
+    node.keys[edge] = std::move(right->keys[0]);
+    std::move(right->keys.begin() + 1, right->keys.begin() + right->n,
+              right->keys.begin());
+
+    if (child->type == NodeType::INTERNAL) {
+        child->edges[child->n + 1] = right->edges[0];
+        std::move(right->edges.begin() + 1, right->edges.begin() + right->n + 1,
+                  right->edges.begin());
+    }
+
+    child->n++;
+    right->n--;
+    return true;
 }
 
+/* The mirror image of borrow_from_right */
 template<typename T, size_t B>
 bool BTreeNode<T, B>::borrow_from_left(BTreeNode<T, B>& node, size_t edge) {
-    // TODO
-    return false;
+    BTreeNode<T, B>* child = node.edges[edge];
+    BTreeNode<T, B>* left = node.edges[edge - 1];
+
+    std::move_backward(child->keys.begin(), child->keys.begin() + child->n,
+                       child->keys.begin() + child->n + 1);
+    child->keys[0] = std::move(node.keys[edge - 1]);
+    node.keys[edge - 1] = std::move(left->keys[left->n - 1]);
+
+    if (child->type == NodeType::INTERNAL) {
+        std::move_backward(child->edges.begin(),
+                           child->edges.begin() + child->n + 1,
+                           child->edges.begin() + child->n + 2);
+        child->edges[0] = left->edges[left->n];
+    }
+
+    child->n++;
+    left->n--;
+    return true;
 }
 
+/* Merge node.edges[idx + 1] and the separator node.keys[idx] into
+   node.edges[idx]. Both children must have B-1 keys. */
 template<typename T, size_t B>
-bool BTreeNode<T, B>::merge_children(BTreeNode<T, B> & node, size_t idx) {
-    // TODO
-    return false;
+bool BTreeNode<T, B>::merge_children(BTreeNodePool<T, B>& pool,
+                                     BTreeNode<T, B>& node, size_t idx) {
+    BTreeNode<T, B>* left = node.edges[idx];
+    BTreeNode<T, B>* right = node.edges[idx + 1];
+
+    left->keys[left->n] = std::move(node.keys[idx]);
+    std::move(right->keys.begin(), right->keys.begin() + right->n,
+              left->keys.begin() + left->n + 1);
+    if (left->type == NodeType::INTERNAL)
+        std::move(right->edges.begin(), right->edges.begin() + right->n + 1,
+                  left->edges.begin() + left->n + 1);
+    left->n += right->n + 1;
+
+    std::move(node.keys.begin() + idx + 1, node.keys.begin() + node.n,
+              node.keys.begin() + idx);
+    std::move(node.edges.begin() + idx + 2, node.edges.begin() + node.n + 1,
+              node.edges.begin() + idx + 1);
+    node.n--;
+
+    pool.release(right);
+    return true;
 }
 
 template<typename T, size_t B>
@@ -304,7 +791,7 @@ template<typename T, size_t B>
 std::pair<BTreeNode<T, B>*, size_t>
 BTreeNode<T, B>::search(BTreeNode<T, B>* node, const T& t) {
     if (node->type == NodeType::LEAF) {
-        for (auto i = 0; i < node->keys.size(); i++)
+        for (auto i = 0; i < node->n; i++)
             if (t == node->keys[i])
                 return { node, i };
 
@@ -334,10 +821,65 @@ size_t BTreeNode<T, B>::depth(void) {
 
 template <typename T, size_t B>
 std::string BTree<T, B>::format(void) {
+    std::ostringstream os;
+
+    write_levels(os);
+
+    return os.str();
+}
+
+template<typename T, size_t B>
+template<typename F>
+void BTree<T, B>::for_each_level(F&& func) const {
     if (!root)
-        return std::string{};
+        return;
+
+    std::vector<const BTreeNode<T, B>*> level{ root }, next;
 
-    return root->format_subtree(root->depth());
+    for (size_t lv = 0; !level.empty(); lv++) {
+        func(lv, std::as_const(level));
+
+        next.clear();
+        for (auto node : level)
+            if (node->type == NodeType::INTERNAL)
+                next.insert(next.end(), node->edges.begin(),
+                            node->edges.begin() + node->n + 1);
+
+        std::swap(level, next);
+    }
+}
+
+/* Same output as format_subtree, one line per level */
+template<typename T, size_t B>
+void BTree<T, B>::write_levels(std::ostream& os) const {
+    for_each_level([&os](size_t, const auto& nodes) {
+        for (auto node : nodes) {
+            node->write_node(os);
+            os << ' ';
+        }
+        os << '\n';
+    });
+}
+
+template<typename T, size_t B>
+BTreeStats BTree<T, B>::stats() const {
+    BTreeStats st;
+
+    for_each_level([&st](size_t lv, const auto& nodes) {
+        BTreeLevelStats level;
+
+        level.num_nodes = nodes.size();
+        level.capacity = nodes.size() * (2 * B - 1);
+        for (auto node : nodes)
+            level.num_keys += node->n;
+
+        st.depth = lv;
+        st.num_nodes += level.num_nodes;
+        st.num_keys += level.num_keys;
+        st.levels.push_back(level);
+    });
+
+    return st;
 }
 
 template<typename T, size_t B>
@@ -366,15 +908,22 @@ template<typename T, size_t B>
 std::string BTreeNode<T, B>::format_node(void) {
     std::ostringstream os;
 
-    os << '[';
-    for (auto i = 0; i < n - 1; i++)
-        os << keys[i] << '|';
-    os << keys[n - 1];
-    os << ']';
+    write_node(os);
 
     return os.str();
 }
 
+template<typename T, size_t B>
+void BTreeNode<T, B>::write_node(std::ostream& os) const {
+    os << '[';
+    for (size_t i = 0; i < n; i++) {
+        if (i > 0)
+            os << '|';
+        os << keys[i];
+    }
+    os << ']';
+}
+
 template<typename T, size_t B>
 std::vector<BTreeNode<T, B>*> BTreeNode<T, B>::find_nodes_at_level(size_t lv) {
     std::vector<BTreeNode<T, B>*> nodes;
@@ -417,10 +966,69 @@ BTreeNode<T, B>::BTreeNode(InputIt begin, InputIt end)
 }
 
 template<typename T, size_t B>
-BTreeNode<T, B>::~BTreeNode() {
-    if (this->type == NodeType::LEAF)
-        return;
+template<typename... Args>
+BTreeNode<T, B>* BTreeNodePool<T, B>::allocate(Args&&... args) {
+    Slot* slot;
+
+    if (free_list) {
+        slot = free_list;
+        free_list = free_list->next;
+        stats.reuses++;
+    } else {
+        if (bump == bump_end) {
+            size_t num_nodes = std::clamp(stats.capacity, MIN_CHUNK_NODES,
+                                          MAX_CHUNK_NODES);
+            chunks.emplace_back(new Slot[num_nodes]);
+            bump = chunks.back().get();
+            bump_end = bump + num_nodes;
+            stats.chunks++;
+            stats.capacity += num_nodes;
+        }
+        slot = bump++;
+    }
 
-    for (auto i = 0; i < n + 1; i++)
-        if (edges[i]) delete edges[i];
+    stats.allocations++;
+    return new (slot->node) BTreeNode<T, B>(std::forward<Args>(args)...);
 }
+
+template<typename T, size_t B>
+void BTreeNodePool<T, B>::release(BTreeNode<T, B>* node) {
+    node->~BTreeNode();
+
+    Slot* slot = reinterpret_cast<Slot*>(node);
+    slot->next = free_list;
+    free_list = slot;
+    stats.releases++;
+}
+
+template<typename T, size_t B>
+void BTreeNodePool<T, B>::reset() {
+    chunks.clear();
+    free_list = bump = bump_end = nullptr;
+    stats.capacity = 0;
+}
+
+template<typename T, size_t B>
+void BTree<T, B>::clear() {
+    /* Trivially destructible keys need no per-node work at all */
+    if constexpr (!std::is_trivially_destructible<T>::value) {
+        std::vector<BTreeNode<T, B>*> stack;
+        if (root)
+            stack.push_back(root);
+
+        while (!stack.empty()) {
+            auto node = stack.back();
+            stack.pop_back();
+
+            if (node->type == NodeType::INTERNAL)
+                stack.insert(stack.end(), node->edges.begin(),
+                             node->edges.begin() + node->n + 1);
+            node->~BTreeNode();
+        }
+    }
+
+    root = nullptr;
+    pool.reset();
+}
+
+#endif // __BTREE_H_
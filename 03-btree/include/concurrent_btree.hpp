@@ -0,0 +1,340 @@
+#ifndef _CONCURRENT_BTREE_HPP
+#define _CONCURRENT_BTREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <array>
+#include <atomic>
+#include <optional>
+#include <thread>
+#include <type_traits>
+
+#include "btree.hpp"
+
+/* A thread-safe B-tree using optimistic lock coupling (OLC).
+ *
+ * Every node carries a version counter whose second lowest bit is a write
+ * lock. Readers never write to shared memory: they remember the version of a
+ * node, read it, and validate that the version did not change before trusting
+ * what they read, restarting from the root otherwise. Writers traverse the
+ * same way, and upgrade to a write lock only on the nodes they modify.
+ *
+ * Like BTree::insert, a writer splits every full child before it steps into
+ * it. A split thus locks only a parent and a child, and never propagates
+ * upwards. Nodes are never freed while the tree is alive, so a reader holding
+ * a stale pointer always points into a valid node.
+ *
+ * Optimistic readers may observe keys in the middle of a write, so T must be
+ * trivially copyable; such reads are always discarded by the validation. */
+
+template<typename T, size_t B = 6>
+struct ConcurrentBTreeNode;
+
+template<typename T, size_t B = 6>
+struct ConcurrentBTree {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "Optimistic readers may copy keys while they are written");
+
+    using Node = ConcurrentBTreeNode<T, B>;
+
+    std::atomic<Node*> root;
+
+    ConcurrentBTree() : root(new Node{}) {}
+    ~ConcurrentBTree() { delete root.load(); }
+
+    bool insert(const T&);
+    bool contains(const T&) const;
+
+    /* Not thread-safe: must not run concurrently with insert */
+    template<typename F>
+    void for_all(F&& func) const { root.load()->for_all(func); }
+
+    const std::optional<size_t> depth() const;
+
+private:
+    ConcurrentBTree(const ConcurrentBTree&);
+    ConcurrentBTree& operator=(const ConcurrentBTree&);
+};
+
+template<typename T, size_t B>
+struct ConcurrentBTreeNode {
+    static constexpr uint64_t LOCKED = 0b10;
+
+    std::atomic<uint64_t> version;
+    NodeType type;
+    size_t n;
+    std::array<T, 2 * B - 1> keys;
+    std::array<ConcurrentBTreeNode*, 2 * B> edges;
+
+    ConcurrentBTreeNode() : version(0), type(NodeType::LEAF), n(0), edges{} {}
+    ~ConcurrentBTreeNode();
+
+    bool is_full() const { return n >= 2 * B - 1; }
+    size_t get_index(const T& t) const;
+
+    /* Optimistic lock coupling primitives. `restart` is set when the caller
+       must give up and start over from the root. */
+    uint64_t read_lock_or_restart(bool& restart) const;
+    void check_or_restart(uint64_t v, bool& restart) const;
+    void upgrade_to_write_lock_or_restart(uint64_t& v, bool& restart);
+    void write_unlock();
+
+    template<typename F>
+    void for_all(F& func) const;
+
+    /* Same as BTreeNode::split_child. Both parent and child must be write
+       locked by the caller. */
+    static void split_child(ConcurrentBTreeNode&, size_t);
+};
+
+template<typename T, size_t B>
+uint64_t ConcurrentBTreeNode<T, B>::read_lock_or_restart(bool& restart) const {
+    uint64_t v = version.load(std::memory_order_acquire);
+    if (v & LOCKED) {
+        std::this_thread::yield();
+        restart = true;
+    }
+    return v;
+}
+
+template<typename T, size_t B>
+void ConcurrentBTreeNode<T, B>::check_or_restart(uint64_t v,
+                                                 bool& restart) const {
+    /* Order the preceding plain reads before the version check */
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (v != version.load(std::memory_order_relaxed))
+        restart = true;
+}
+
+template<typename T, size_t B>
+void ConcurrentBTreeNode<T, B>::upgrade_to_write_lock_or_restart(uint64_t& v,
+                                                                 bool& restart) {
+    if (version.compare_exchange_strong(v, v + LOCKED,
+                                        std::memory_order_acquire))
+        v += LOCKED;
+    else
+        restart = true;
+}
+
+template<typename T, size_t B>
+void ConcurrentBTreeNode<T, B>::write_unlock() {
+    /* Clears the lock bit and bumps the counter in one step */
+    version.fetch_add(LOCKED, std::memory_order_release);
+}
+
+template<typename T, size_t B>
+bool ConcurrentBTree<T, B>::insert(const T& t) {
+    for (;;) {
+        bool restart = false;
+
+        Node* node = root.load(std::memory_order_acquire);
+        uint64_t v = node->read_lock_or_restart(restart);
+        if (restart || node != root.load(std::memory_order_acquire))
+            continue;
+
+        /* Make sure the root node is not full. The old root stays locked
+           until the new root is published, so that everyone who saw it as
+           the root restarts. */
+        if (node->is_full()) {
+            node->upgrade_to_write_lock_or_restart(v, restart);
+            if (restart)
+                continue;
+
+            Node* new_root = new Node{};
+            new_root->type = NodeType::INTERNAL;
+            new_root->edges[0] = node;
+            Node::split_child(*new_root, 0);
+            root.store(new_root, std::memory_order_release);
+
+            node->write_unlock();
+            continue;
+        }
+
+        /* Descend, splitting every full child before stepping into it */
+        for (;;) {
+            size_t idx = node->get_index(t);
+
+            if (idx < node->n && node->keys[idx] == t) {
+                node->check_or_restart(v, restart);
+                if (restart)
+                    break;
+                return false;
+            }
+
+            if (node->type == NodeType::LEAF) {
+                node->upgrade_to_write_lock_or_restart(v, restart);
+                if (restart)
+                    break;
+
+                for (size_t i = node->n; i != idx; i--)
+                    node->keys[i] = node->keys[i - 1];
+                node->keys[idx] = t;
+                node->n++;
+
+                node->write_unlock();
+                return true;
+            }
+
+            Node* child = node->edges[idx];
+            node->check_or_restart(v, restart);
+            if (restart || !child)
+                break;
+
+            uint64_t cv = child->read_lock_or_restart(restart);
+            if (restart)
+                break;
+
+            /* A split of the child between the first check and its lock
+               would have moved keys out of it */
+            node->check_or_restart(v, restart);
+            if (restart)
+                break;
+
+            if (child->is_full()) {
+                node->upgrade_to_write_lock_or_restart(v, restart);
+                if (restart)
+                    break;
+
+                child->upgrade_to_write_lock_or_restart(cv, restart);
+                if (restart) {
+                    node->write_unlock();
+                    break;
+                }
+
+                Node::split_child(*node, idx);
+
+                child->write_unlock();
+                node->write_unlock();
+                restart = true;
+                break;
+            }
+
+            node = child;
+            v = cv;
+        }
+    }
+}
+
+template<typename T, size_t B>
+bool ConcurrentBTree<T, B>::contains(const T& t) const {
+    for (;;) {
+        bool restart = false;
+
+        const Node* node = root.load(std::memory_order_acquire);
+        uint64_t v = node->read_lock_or_restart(restart);
+        if (restart || node != root.load(std::memory_order_acquire))
+            continue;
+
+        for (;;) {
+            size_t idx = node->get_index(t);
+            bool found = idx < node->n && node->keys[idx] == t;
+
+            if (found || node->type == NodeType::LEAF) {
+                node->check_or_restart(v, restart);
+                if (restart)
+                    break;
+                return found;
+            }
+
+            const Node* child = node->edges[idx];
+            node->check_or_restart(v, restart);
+            if (restart || !child)
+                break;
+
+            uint64_t cv = child->read_lock_or_restart(restart);
+            if (restart)
+                break;
+
+            /* A split of the child between the first check and its lock
+               would have moved keys out of it */
+            node->check_or_restart(v, restart);
+            if (restart)
+                break;
+
+            node = child;
+            v = cv;
+        }
+    }
+}
+
+template<typename T, size_t B>
+const std::optional<size_t> ConcurrentBTree<T, B>::depth() const {
+    const Node* node = root.load();
+    if (node->n == 0)
+        return std::nullopt;
+
+    size_t d = 0;
+    for (; node->type == NodeType::INTERNAL; node = node->edges[0])
+        d++;
+
+    return d;
+}
+
+/* Same as BTreeNode::get_index. `n` may be stale, but it is always a value
+   that was once valid, so the loop stays within `keys`. */
+template<typename T, size_t B>
+size_t ConcurrentBTreeNode<T, B>::get_index(const T& t) const {
+    size_t idx = 0, num_keys = n;
+    while (idx < num_keys) {
+        if (t <= keys[idx])
+            return idx;
+        idx++;
+    }
+    return idx;
+}
+
+/* The new right sibling is fully built before it becomes reachable through
+   parent.edges, and the parent's `edges[n + 1]` is filled before `n` grows,
+   so an optimistic reader never follows a null or dangling edge. */
+template<typename T, size_t B>
+void ConcurrentBTreeNode<T, B>::split_child(ConcurrentBTreeNode& parent,
+                                            size_t idx) {
+    ConcurrentBTreeNode* child = parent.edges[idx];
+
+    ConcurrentBTreeNode* new_node = new ConcurrentBTreeNode{};
+    new_node->type = child->type;
+    new_node->n = B - 1;
+    for (size_t i = 0; i < B - 1; i++) {
+        new_node->keys[i] = child->keys[i + B];
+        new_node->edges[i] = child->edges[i + B];
+    }
+    new_node->edges[B - 1] = child->edges[2 * B - 1];
+
+    parent.edges[parent.n + 1] = parent.edges[parent.n];
+    for (size_t i = parent.n; i != idx; i--) {
+        parent.keys[i] = parent.keys[i - 1];
+        parent.edges[i] = parent.edges[i - 1];
+    }
+    parent.keys[idx] = child->keys[B - 1];
+    parent.edges[idx + 1] = new_node;
+    parent.n++;
+
+    child->n = B - 1;
+}
+
+template<typename T, size_t B>
+template<typename F>
+void ConcurrentBTreeNode<T, B>::for_all(F& func) const {
+    if (type == NodeType::LEAF) {
+        for (size_t j = 0; j < n; j++)
+            func(keys[j]);
+        return;
+    }
+
+    for (size_t j = 0; j < n; j++) {
+        edges[j]->for_all(func);
+        func(keys[j]);
+    }
+    edges[n]->for_all(func);
+}
+
+template<typename T, size_t B>
+ConcurrentBTreeNode<T, B>::~ConcurrentBTreeNode() {
+    if (type == NodeType::LEAF)
+        return;
+
+    for (size_t i = 0; i < n + 1; i++)
+        delete edges[i];
+}
+
+#endif
@@ -0,0 +1,552 @@
+#ifndef _DISK_BTREE_HPP
+#define _DISK_BTREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <array>
+#include <list>
+#include <memory>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "btree.hpp"
+
+/* A B-tree whose nodes live in fixed-size pages of a file. Edges are page
+   IDs instead of pointers, and every page access goes through an LRU buffer
+   pool, so only `pool_frames` pages are resident at any time. */
+
+using page_id_t = uint32_t;
+
+constexpr page_id_t INVALID_PAGE = ~page_id_t{0};
+constexpr size_t PAGE_SIZE = 4096;
+
+/* Reads and writes whole pages of the backing file. */
+class Pager {
+public:
+    explicit Pager(const std::string& path);
+    ~Pager();
+
+    void read_page(page_id_t, char*);
+    void write_page(page_id_t, const char*);
+    page_id_t allocate_page() { return num_pages++; }
+    page_id_t get_num_pages() const { return num_pages; }
+
+private:
+    int fd;
+    page_id_t num_pages;
+
+    Pager(const Pager&);
+    Pager& operator=(const Pager&);
+};
+
+struct BufferPoolStats {
+    size_t hits = 0;
+    size_t misses = 0;      /* Page faults: the page had to be read in */
+    size_t evictions = 0;
+    size_t writebacks = 0;
+};
+
+/* A fixed number of in-memory frames caching pages of a Pager. A page must be
+   pinned while it is in use, and a pinned page is never evicted. Unpinned
+   frames are recycled in least-recently-used order. */
+class BufferPool {
+public:
+    BufferPool(Pager& pager, size_t num_frames);
+    ~BufferPool();
+
+    char* pin(page_id_t);
+    char* new_page(page_id_t&);
+    void unpin(page_id_t, bool dirty);
+    void flush_all();
+
+    const BufferPoolStats& get_stats() const { return stats; }
+    size_t get_num_frames() const { return frames.size(); }
+
+private:
+    struct Frame {
+        page_id_t page = INVALID_PAGE;
+        size_t pin_count = 0;
+        bool dirty = false;
+        std::list<size_t>::iterator lru_pos;
+    };
+
+    Pager& pager;
+    std::unique_ptr<char[]> data;
+    std::vector<Frame> frames;
+    std::vector<size_t> free_frames;
+    std::list<size_t> lru;      /* Unpinned frames, least recent first */
+    std::unordered_map<page_id_t, size_t> page_table;
+    BufferPoolStats stats;
+
+    char* frame_data(size_t f) { return data.get() + f * PAGE_SIZE; }
+    size_t get_victim_frame();
+
+    BufferPool(const BufferPool&);
+    BufferPool& operator=(const BufferPool&);
+};
+
+/* Pins a page for the lifetime of the guard */
+class PageGuard {
+public:
+    PageGuard() : pool(nullptr), id(INVALID_PAGE), data(nullptr), dirty(false) {}
+    PageGuard(BufferPool& p, page_id_t i)
+        : pool(&p), id(i), data(p.pin(i)), dirty(false) {}
+    PageGuard(PageGuard&& o) { steal(o); }
+    PageGuard& operator=(PageGuard&& o) {
+        if (this != &o) { release(); steal(o); }
+        return *this;
+    }
+    ~PageGuard() { release(); }
+
+    static PageGuard create(BufferPool& p) {
+        PageGuard g;
+        g.pool = &p;
+        g.data = p.new_page(g.id);
+        g.dirty = true;
+        return g;
+    }
+
+    template<typename P>
+    P* as() { return reinterpret_cast<P*>(data); }
+
+    page_id_t get_id() const { return id; }
+    void mark_dirty() { dirty = true; }
+
+    void release() {
+        if (pool && id != INVALID_PAGE)
+            pool->unpin(id, dirty);
+        pool = nullptr;
+        id = INVALID_PAGE;
+        data = nullptr;
+        dirty = false;
+    }
+
+private:
+    BufferPool* pool;
+    page_id_t id;
+    char* data;
+    bool dirty;
+
+    void steal(PageGuard& o) {
+        pool = o.pool; id = o.id; data = o.data; dirty = o.dirty;
+        o.pool = nullptr; o.id = INVALID_PAGE; o.data = nullptr; o.dirty = false;
+    }
+};
+
+/* Choose B such that a node fills (but does not exceed) a single page */
+template<typename T>
+constexpr size_t default_disk_btree_order() {
+    return (PAGE_SIZE - 2 * sizeof(uint32_t) - sizeof(page_id_t))
+        / (2 * (sizeof(T) + sizeof(page_id_t)));
+}
+
+/* The on-page layout of a node. It is a plain struct that is copied from and
+   to the file byte by byte, so T must be trivially copyable. */
+template<typename T, size_t B>
+struct DiskBTreeNode {
+    uint32_t type;
+    uint32_t n;
+    std::array<T, 2 * B - 1> keys;
+    std::array<page_id_t, 2 * B> edges;
+
+    bool is_leaf() const { return type == static_cast<uint32_t>(NodeType::LEAF); }
+    bool is_full() const { return n >= 2 * B - 1; }
+    size_t get_index(const T& t) const;
+};
+
+template<typename T, size_t B = default_disk_btree_order<T>()>
+struct DiskBTree {
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "DiskBTree keys are stored as raw bytes");
+    static_assert(B >= 2, "B must be at least 2");
+    static_assert(sizeof(DiskBTreeNode<T, B>) <= PAGE_SIZE,
+                  "A node must fit in a single page");
+
+    using Node = DiskBTreeNode<T, B>;
+
+    DiskBTree(const std::string& path, size_t pool_frames = 1024);
+    ~DiskBTree();
+
+    bool insert(const T&);
+    bool find(const T&);
+
+    /* Call func on every key in [lo, hi], in order */
+    template<typename F>
+    void scan(const T& lo, const T& hi, F&& func);
+
+    const std::optional<size_t> depth();
+
+    size_t get_size() const { return size; }
+    const BufferPoolStats& get_pool_stats() const { return pool.get_stats(); }
+    void flush();
+
+private:
+    /* Page 0 holds the tree metadata */
+    struct Meta {
+        uint64_t magic;
+        page_id_t root;
+        page_id_t num_pages;
+        uint64_t size;
+    };
+    static constexpr uint64_t MAGIC = 0x4254524545504731ull;
+
+    Pager pager;
+    BufferPool pool;
+    page_id_t root;
+    size_t size;
+
+    void split_child(Node& parent, size_t idx, Node& child, PageGuard& new_guard);
+
+    template<typename F>
+    bool scan_subtree(page_id_t, const T& lo, const T& hi, F& func);
+};
+
+inline Pager::Pager(const std::string& path) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0)
+        throw std::runtime_error("Pager: cannot open " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) < 0) {
+        ::close(fd);
+        throw std::runtime_error("Pager: cannot stat " + path);
+    }
+    num_pages = st.st_size / PAGE_SIZE;
+}
+
+inline Pager::~Pager() {
+    ::close(fd);
+}
+
+inline void Pager::read_page(page_id_t id, char* buf) {
+    ssize_t done = ::pread(fd, buf, PAGE_SIZE, (off_t)id * PAGE_SIZE);
+    if (done < 0)
+        throw std::runtime_error("Pager: read failed");
+
+    /* Pages allocated but never written are read as zeros */
+    if ((size_t)done < PAGE_SIZE)
+        std::memset(buf + done, 0, PAGE_SIZE - done);
+}
+
+inline void Pager::write_page(page_id_t id, const char* buf) {
+    ssize_t done = ::pwrite(fd, buf, PAGE_SIZE, (off_t)id * PAGE_SIZE);
+    if (done != (ssize_t)PAGE_SIZE)
+        throw std::runtime_error("Pager: write failed");
+}
+
+inline BufferPool::BufferPool(Pager& p, size_t num_frames)
+    : pager(p), data(new char[num_frames * PAGE_SIZE]), frames(num_frames) {
+    for (size_t f = num_frames; f > 0; f--)
+        free_frames.push_back(f - 1);
+}
+
+inline BufferPool::~BufferPool() {
+    flush_all();
+}
+
+inline size_t BufferPool::get_victim_frame() {
+    if (!free_frames.empty()) {
+        size_t f = free_frames.back();
+        free_frames.pop_back();
+        return f;
+    }
+
+    if (lru.empty())
+        throw std::runtime_error("BufferPool: all frames are pinned");
+
+    size_t f = lru.front();
+    lru.pop_front();
+
+    Frame& frame = frames[f];
+    if (frame.dirty) {
+        pager.write_page(frame.page, frame_data(f));
+        stats.writebacks++;
+    }
+    page_table.erase(frame.page);
+    stats.evictions++;
+
+    frame = Frame{};
+    return f;
+}
+
+inline char* BufferPool::pin(page_id_t id) {
+    auto it = page_table.find(id);
+    if (it != page_table.end()) {
+        Frame& frame = frames[it->second];
+        if (frame.pin_count++ == 0)
+            lru.erase(frame.lru_pos);
+        stats.hits++;
+        return frame_data(it->second);
+    }
+
+    size_t f = get_victim_frame();
+    pager.read_page(id, frame_data(f));
+    stats.misses++;
+
+    frames[f].page = id;
+    frames[f].pin_count = 1;
+    page_table.emplace(id, f);
+    return frame_data(f);
+}
+
+/* Allocate a fresh zero-filled page. It is returned pinned and dirty. */
+inline char* BufferPool::new_page(page_id_t& id) {
+    size_t f = get_victim_frame();
+    id = pager.allocate_page();
+    std::memset(frame_data(f), 0, PAGE_SIZE);
+
+    frames[f].page = id;
+    frames[f].pin_count = 1;
+    frames[f].dirty = true;
+    page_table.emplace(id, f);
+    return frame_data(f);
+}
+
+inline void BufferPool::unpin(page_id_t id, bool dirty) {
+    Frame& frame = frames[page_table.at(id)];
+    frame.dirty |= dirty;
+    if (--frame.pin_count == 0)
+        frame.lru_pos = lru.insert(lru.end(), page_table.at(id));
+}
+
+inline void BufferPool::flush_all() {
+    for (size_t f = 0; f < frames.size(); f++) {
+        if (frames[f].page != INVALID_PAGE && frames[f].dirty) {
+            pager.write_page(frames[f].page, frame_data(f));
+            frames[f].dirty = false;
+            stats.writebacks++;
+        }
+    }
+}
+
+/* Same as BTreeNode::get_index, but with a binary search */
+template<typename T, size_t B>
+size_t DiskBTreeNode<T, B>::get_index(const T& t) const {
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        if (keys[mid] < t)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+template<typename T, size_t B>
+DiskBTree<T, B>::DiskBTree(const std::string& path, size_t pool_frames)
+    : pager(path), pool(pager, pool_frames), root(INVALID_PAGE), size(0) {
+    /* A split pins the parent, the child and the new sibling at once, and
+       the metadata page is pinned while the root changes. */
+    if (pool_frames < 4)
+        throw std::invalid_argument("DiskBTree: need at least 4 frames");
+
+    if (pager.get_num_pages() == 0) {
+        PageGuard meta_guard = PageGuard::create(pool);
+        Meta* meta = meta_guard.as<Meta>();
+        meta->magic = MAGIC;
+        meta->root = INVALID_PAGE;
+        meta->num_pages = 1;
+        meta->size = 0;
+        return;
+    }
+
+    PageGuard meta_guard(pool, 0);
+    Meta* meta = meta_guard.as<Meta>();
+    if (meta->magic != MAGIC)
+        throw std::runtime_error("DiskBTree: " + path + " is not a B-tree file");
+
+    root = meta->root;
+    size = meta->size;
+    while (pager.get_num_pages() < meta->num_pages)
+        pager.allocate_page();
+}
+
+template<typename T, size_t B>
+DiskBTree<T, B>::~DiskBTree() {
+    flush();
+}
+
+template<typename T, size_t B>
+void DiskBTree<T, B>::flush() {
+    {
+        PageGuard meta_guard(pool, 0);
+        Meta* meta = meta_guard.as<Meta>();
+        meta->root = root;
+        meta->num_pages = pager.get_num_pages();
+        meta->size = size;
+        meta_guard.mark_dirty();
+    }
+    pool.flush_all();
+}
+
+template<typename T, size_t B>
+bool DiskBTree<T, B>::insert(const T& t) {
+    if (root == INVALID_PAGE) {
+        PageGuard guard = PageGuard::create(pool);
+        Node* node = guard.as<Node>();
+        node->type = static_cast<uint32_t>(NodeType::LEAF);
+        node->n = 1;
+        node->keys[0] = t;
+        root = guard.get_id();
+        size++;
+        return true;
+    }
+
+    PageGuard guard(pool, root);
+
+    /* Make sure the root node is not full, exactly as BTree::insert does */
+    if (guard.as<Node>()->is_full()) {
+        PageGuard new_root = PageGuard::create(pool);
+        Node* node = new_root.as<Node>();
+        node->type = static_cast<uint32_t>(NodeType::INTERNAL);
+        node->n = 0;
+        node->edges[0] = root;
+
+        PageGuard sibling;
+        split_child(*node, 0, *guard.as<Node>(), sibling);
+        guard.mark_dirty();
+
+        root = new_root.get_id();
+        guard = std::move(new_root);
+    }
+
+    /* Descend, splitting every full child before stepping into it. Only the
+       current node and its child are pinned at any time. */
+    for (;;) {
+        Node* node = guard.as<Node>();
+        size_t idx = node->get_index(t);
+
+        if (idx < node->n && node->keys[idx] == t)
+            return false;
+
+        if (node->is_leaf()) {
+            for (size_t i = node->n; i != idx; i--)
+                node->keys[i] = node->keys[i - 1];
+            node->keys[idx] = t;
+            node->n++;
+            guard.mark_dirty();
+            size++;
+            return true;
+        }
+
+        PageGuard child(pool, node->edges[idx]);
+        if (child.as<Node>()->is_full()) {
+            PageGuard sibling;
+            split_child(*node, idx, *child.as<Node>(), sibling);
+            guard.mark_dirty();
+            child.mark_dirty();
+
+            if (node->keys[idx] == t)
+                return false;
+            if (node->keys[idx] < t)
+                child = std::move(sibling);
+        }
+
+        guard = std::move(child);
+    }
+}
+
+/* Split the full `child` at parent.edges[idx]. The new right sibling is
+   returned pinned in `new_guard`. */
+template<typename T, size_t B>
+void DiskBTree<T, B>::split_child(Node& parent, size_t idx, Node& child,
+                                  PageGuard& new_guard) {
+    new_guard = PageGuard::create(pool);
+    Node* new_node = new_guard.as<Node>();
+
+    new_node->type = child.type;
+    child.n = new_node->n = B - 1;
+    for (size_t i = 0; i < B - 1; i++) {
+        new_node->keys[i] = child.keys[i + B];
+        new_node->edges[i] = child.edges[i + B];
+    }
+    new_node->edges[B - 1] = child.edges[2 * B - 1];
+
+    parent.edges[parent.n + 1] = parent.edges[parent.n];
+    for (size_t i = parent.n; i != idx; i--) {
+        parent.keys[i] = parent.keys[i - 1];
+        parent.edges[i] = parent.edges[i - 1];
+    }
+    parent.keys[idx] = child.keys[B - 1];
+    parent.edges[idx + 1] = new_guard.get_id();
+    parent.n++;
+}
+
+template<typename T, size_t B>
+bool DiskBTree<T, B>::find(const T& t) {
+    page_id_t id = root;
+
+    while (id != INVALID_PAGE) {
+        PageGuard guard(pool, id);
+        const Node* node = guard.as<Node>();
+        size_t idx = node->get_index(t);
+
+        if (idx < node->n && node->keys[idx] == t)
+            return true;
+        if (node->is_leaf())
+            return false;
+
+        id = node->edges[idx];
+    }
+
+    return false;
+}
+
+template<typename T, size_t B>
+template<typename F>
+void DiskBTree<T, B>::scan(const T& lo, const T& hi, F&& func) {
+    if (root != INVALID_PAGE && !(hi < lo))
+        scan_subtree(root, lo, hi, func);
+}
+
+/* Returns false once a key greater than `hi` has been seen. Pins at most one
+   page per level. */
+template<typename T, size_t B>
+template<typename F>
+bool DiskBTree<T, B>::scan_subtree(page_id_t id, const T& lo, const T& hi,
+                                   F& func) {
+    PageGuard guard(pool, id);
+    const Node* node = guard.as<Node>();
+
+    for (size_t i = node->get_index(lo); i <= node->n; i++) {
+        if (!node->is_leaf() && !scan_subtree(node->edges[i], lo, hi, func))
+            return false;
+
+        if (i == node->n)
+            break;
+        if (hi < node->keys[i])
+            return false;
+
+        func(node->keys[i]);
+    }
+
+    return true;
+}
+
+template<typename T, size_t B>
+const std::optional<size_t> DiskBTree<T, B>::depth() {
+    if (root == INVALID_PAGE)
+        return std::nullopt;
+
+    size_t d = 0;
+    PageGuard guard(pool, root);
+    while (!guard.as<Node>()->is_leaf()) {
+        guard = PageGuard(pool, guard.as<Node>()->edges[0]);
+        d++;
+    }
+
+    return d;
+}
+
+#endif
@@ -0,0 +1,374 @@
+#ifndef _STRING_BTREE_HPP
+#define _STRING_BTREE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <algorithm>
+#include <array>
+#include <optional>
+#include <string>
+#include <string_view>
+
+#include "btree.hpp"
+
+/* A B-tree of strings with per-node prefix compression.
+ *
+ * Each node keeps the longest common prefix of its keys once, followed by
+ * the remaining suffixes, all in a single byte buffer:
+ *
+ *   buf = prefix | suffix 0 | suffix 1 | ... | suffix n-1
+ *
+ * where suffix i spans [offsets[i], offsets[i + 1]). A lookup compares the
+ * key with the prefix once per node, and then compares only suffixes. Keys
+ * sharing long prefixes (URLs, paths, ...) thus take far less space than
+ * one std::string per slot, and all the keys of a node share one
+ * allocation. */
+
+template<size_t B = 16>
+struct StringBTreeNode;
+
+template<size_t B = 16>
+struct StringBTree {
+    StringBTreeNode<B>* root = nullptr;
+
+    StringBTree() = default;
+    ~StringBTree() { delete root; }
+
+    bool insert(std::string_view);
+    bool contains(std::string_view) const;
+
+    /* In-order traversal. func receives every full key as a std::string. */
+    template<typename F>
+    void for_all(F&& func) const;
+
+    const std::optional<size_t> depth() const;
+
+    size_t get_size() const { return size; }
+    size_t get_num_nodes() const { return num_nodes; }
+
+    /* Bytes taken by the nodes and their buffers */
+    size_t memory_usage() const;
+
+private:
+    size_t size = 0;
+    size_t num_nodes = 0;
+
+    StringBTree(const StringBTree&);
+    StringBTree& operator=(const StringBTree&);
+};
+
+template<size_t B>
+struct StringBTreeNode {
+    NodeType type;
+    size_t n;
+    uint32_t prefix_len;
+    std::array<uint32_t, 2 * B> offsets;
+    std::string buf;
+    std::array<StringBTreeNode*, 2 * B> edges;
+
+    StringBTreeNode() : type(NodeType::LEAF), n(0), prefix_len(0) {
+        offsets[0] = 0;
+    }
+    ~StringBTreeNode();
+
+    bool is_full() const { return n >= 2 * B - 1; }
+
+    std::string_view prefix() const {
+        return std::string_view(buf.data(), prefix_len);
+    }
+
+    std::string_view suffix(size_t i) const {
+        return std::string_view(buf.data() + prefix_len + offsets[i],
+                                offsets[i + 1] - offsets[i]);
+    }
+
+    std::string key(size_t i) const {
+        std::string k{prefix()};
+        k.append(suffix(i));
+        return k;
+    }
+
+    /* Same contract as BTreeNode::get_index: the position of the first key
+       that is not less than t. `equal` tells whether that key equals t. */
+    size_t get_index(std::string_view t, bool& equal) const;
+
+    void insert_key(size_t idx, std::string_view t);
+    void shrink_prefix(size_t len);
+
+    /* Move keys [from, to) of src into this empty node, with the longest
+       possible prefix. */
+    void assign_keys(const StringBTreeNode& src, size_t from, size_t to);
+
+    bool insert(std::string_view t, size_t& num_nodes);
+    static void split_child(StringBTreeNode&, size_t, size_t& num_nodes);
+
+    template<typename F>
+    void for_all(F& func) const;
+
+    size_t memory_usage() const;
+};
+
+static inline size_t common_prefix_length(std::string_view a,
+                                          std::string_view b) {
+    size_t len = std::min(a.size(), b.size());
+    return std::mismatch(a.begin(), a.begin() + len, b.begin()).first - a.begin();
+}
+
+template<size_t B>
+size_t StringBTreeNode<B>::get_index(std::string_view t, bool& equal) const {
+    equal = false;
+
+    if (n == 0)
+        return 0;
+
+    /* Every key of this node starts with the prefix. If t does not, it is
+       smaller or greater than all of them, and the first mismatching byte
+       tells which. */
+    size_t m = common_prefix_length(t, prefix());
+    if (m < prefix_len) {
+        if (m == t.size() || (unsigned char)t[m] < (unsigned char)buf[m])
+            return 0;
+        return n;
+    }
+
+    std::string_view tail = t.substr(prefix_len);
+    size_t lo = 0, hi = n;
+    while (lo < hi) {
+        size_t mid = (lo + hi) / 2;
+        int c = suffix(mid).compare(tail);
+        if (c < 0) {
+            lo = mid + 1;
+        } else {
+            if (c == 0) {
+                equal = true;
+                return mid;
+            }
+            hi = mid;
+        }
+    }
+
+    return lo;
+}
+
+/* Keep only the first `len` bytes as the prefix, and prepend the rest of
+   the old prefix to every suffix. */
+template<size_t B>
+void StringBTreeNode<B>::shrink_prefix(size_t len) {
+    if (len >= prefix_len)
+        return;
+
+    std::string_view dropped = prefix().substr(len);
+    std::string new_buf;
+    new_buf.reserve(buf.size() + (n - 1) * dropped.size());
+    new_buf.append(prefix().substr(0, len));
+
+    for (size_t i = 0; i < n; i++) {
+        new_buf.append(dropped);
+        new_buf.append(suffix(i));
+    }
+
+    for (size_t i = 1; i <= n; i++)
+        offsets[i] += i * dropped.size();
+
+    prefix_len = len;
+    buf = std::move(new_buf);
+}
+
+/* Insert the key t at position idx. The node must not be full. */
+template<size_t B>
+void StringBTreeNode<B>::insert_key(size_t idx, std::string_view t) {
+    if (n == 0) {
+        /* A lone key is all prefix */
+        buf.assign(t);
+        prefix_len = t.size();
+        offsets[0] = offsets[1] = 0;
+        n = 1;
+        return;
+    }
+
+    shrink_prefix(common_prefix_length(t, prefix()));
+
+    std::string_view tail = t.substr(prefix_len);
+    buf.insert(prefix_len + offsets[idx], tail);
+
+    for (size_t i = n + 1; i > idx; i--)
+        offsets[i] = offsets[i - 1] + tail.size();
+    n++;
+}
+
+template<size_t B>
+void StringBTreeNode<B>::assign_keys(const StringBTreeNode& src, size_t from,
+                                     size_t to) {
+    n = to - from;
+
+    /* The keys are sorted, so the first and the last share the longest
+       common prefix of all of them. */
+    size_t extra = n > 0 ? common_prefix_length(src.suffix(from),
+                                                src.suffix(to - 1)) : 0;
+
+    buf.clear();
+    buf.reserve(src.prefix_len + src.offsets[to] - src.offsets[from] - n * extra);
+    buf.append(src.prefix());
+    buf.append(src.suffix(from).substr(0, extra));
+    prefix_len = buf.size();
+
+    offsets[0] = 0;
+    for (size_t i = 0; i < n; i++) {
+        buf.append(src.suffix(from + i).substr(extra));
+        offsets[i + 1] = buf.size() - prefix_len;
+    }
+}
+
+template<size_t B>
+bool StringBTree<B>::insert(std::string_view t) {
+    if (!root) {
+        root = new StringBTreeNode<B>{};
+        num_nodes++;
+    }
+
+    if (root->is_full()) {
+        auto new_root = new StringBTreeNode<B>{};
+        new_root->type = NodeType::INTERNAL;
+        new_root->edges[0] = root;
+        StringBTreeNode<B>::split_child(*new_root, 0, num_nodes);
+        root = new_root;
+        num_nodes++;
+    }
+
+    if (!root->insert(t, num_nodes))
+        return false;
+
+    size++;
+    return true;
+}
+
+/* Same top-down insertion as BTreeNode::insert */
+template<size_t B>
+bool StringBTreeNode<B>::insert(std::string_view t, size_t& num_nodes) {
+    StringBTreeNode* node = this;
+
+    for (;;) {
+        bool equal;
+        size_t idx = node->get_index(t, equal);
+        if (equal)
+            return false;
+
+        if (node->type == NodeType::LEAF) {
+            node->insert_key(idx, t);
+            return true;
+        }
+
+        if (node->edges[idx]->is_full()) {
+            split_child(*node, idx, num_nodes);
+            continue;
+        }
+
+        node = node->edges[idx];
+    }
+}
+
+template<size_t B>
+void StringBTreeNode<B>::split_child(StringBTreeNode& parent, size_t idx,
+                                     size_t& num_nodes) {
+    StringBTreeNode* child = parent.edges[idx];
+    StringBTreeNode* right = new StringBTreeNode{};
+    StringBTreeNode left;
+    std::string middle = child->key(B - 1);
+
+    right->type = child->type;
+    right->assign_keys(*child, B, 2 * B - 1);
+    for (size_t i = 0; i < B; i++)
+        right->edges[i] = child->edges[i + B];
+
+    /* The lower half stays in child, re-compressed with its own prefix */
+    left.assign_keys(*child, 0, B - 1);
+    child->n = left.n;
+    child->prefix_len = left.prefix_len;
+    child->offsets = left.offsets;
+    child->buf = std::move(left.buf);
+    left.n = 0;
+
+    parent.edges[parent.n + 1] = parent.edges[parent.n];
+    for (size_t i = parent.n; i > idx + 1; i--)
+        parent.edges[i] = parent.edges[i - 1];
+    parent.insert_key(idx, middle);
+    parent.edges[idx + 1] = right;
+
+    num_nodes++;
+}
+
+template<size_t B>
+bool StringBTree<B>::contains(std::string_view t) const {
+    const StringBTreeNode<B>* node = root;
+
+    while (node) {
+        bool equal;
+        size_t idx = node->get_index(t, equal);
+        if (equal)
+            return true;
+        if (node->type == NodeType::LEAF)
+            return false;
+        node = node->edges[idx];
+    }
+
+    return false;
+}
+
+template<size_t B>
+template<typename F>
+void StringBTree<B>::for_all(F&& func) const {
+    if (root)
+        root->for_all(func);
+}
+
+template<size_t B>
+template<typename F>
+void StringBTreeNode<B>::for_all(F& func) const {
+    for (size_t j = 0; j < n; j++) {
+        if (type == NodeType::INTERNAL)
+            edges[j]->for_all(func);
+        func(key(j));
+    }
+
+    if (type == NodeType::INTERNAL)
+        edges[n]->for_all(func);
+}
+
+template<size_t B>
+const std::optional<size_t> StringBTree<B>::depth() const {
+    if (!root || root->n == 0)
+        return std::nullopt;
+
+    size_t d = 0;
+    for (auto node = root; node->type == NodeType::INTERNAL; node = node->edges[0])
+        d++;
+
+    return d;
+}
+
+template<size_t B>
+size_t StringBTree<B>::memory_usage() const {
+    return root ? root->memory_usage() : 0;
+}
+
+template<size_t B>
+size_t StringBTreeNode<B>::memory_usage() const {
+    size_t bytes = sizeof(*this) + buf.capacity();
+
+    if (type == NodeType::INTERNAL)
+        for (size_t i = 0; i <= n; i++)
+            bytes += edges[i]->memory_usage();
+
+    return bytes;
+}
+
+template<size_t B>
+StringBTreeNode<B>::~StringBTreeNode() {
+    if (type == NodeType::LEAF)
+        return;
+
+    for (size_t i = 0; i < n + 1; i++)
+        delete edges[i];
+}
+
+#endif
@@ -32,6 +32,7 @@ TEST_CASE("Delete", "[btree]") {
         tree.remove(i);
 
     REQUIRE(tree.root->n == 0);
+    REQUIRE(!tree.find_rightmost_key().has_value());
 }
 
 TEST_CASE("Inorder traversal after deletion", "[btree]") {
@@ -1,31 +1,223 @@
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <fstream>
+#include <iterator>
 #include <random>
-
-#include <openssl/sha.h>
+#include <set>
+#include <string>
+#include <vector>
 
 #include "btree.hpp"
 
-extern "C" int LLVMFuzzerTestOneInput(const char* data, size_t size) {
-    BTree<unsigned char, 2> btree;
-    unsigned char cs[20]; // The output size of sha1 has is 20 bytes
-    std::vector<unsigned char> ds;
+/* Differential fuzzing of BTree against std::set.
+ *
+ * An input is decoded into a sequence of operations, which are applied to a
+ * BTree and to a std::set; any disagreement, or a broken B-tree invariant,
+ * aborts. Every input runs over several values of B.
+ *
+ * Built with -DBTREE_FUZZ_LIBFUZZER, this is a libFuzzer target. Otherwise
+ * it is a standalone program that either replays corpus files or generates
+ * long random sequences, and reports the throughput of the BTree alone, so
+ * that the corpus doubles as a performance regression suite:
+ *
+ *   btree_fuzz [-n num_ops] [-s seed] [corpus files...]
+ */
+
+enum class OpKind : uint8_t { INSERT, REMOVE, CONTAINS, CHECK };
+
+struct Op {
+    OpKind kind;
+    int key;
+};
+
+static void fail(const char* what, int key, size_t B) {
+    fprintf(stderr, "[*] btree_fuzz: %s failed (key %d, B = %zu)\n", what, key, B);
+    abort();
+}
+
+/* Every input byte triple is one operation: an opcode and a 16-bit key.
+   The small key space makes removals and lookups hit often. */
+static std::vector<Op> decode(const uint8_t* data, size_t size) {
+    std::vector<Op> ops;
+
+    for (size_t i = 0; i + 3 <= size; i += 3) {
+        int key = data[i + 1] | (data[i + 2] << 8);
+
+        switch (data[i] % 8) {
+        case 0: case 1: case 2:
+            ops.push_back({ OpKind::INSERT, key });
+            break;
+        case 3: case 4:
+            ops.push_back({ OpKind::REMOVE, key });
+            break;
+        case 5: case 6:
+            ops.push_back({ OpKind::CONTAINS, key });
+            break;
+        default:
+            ops.push_back({ OpKind::CHECK, key });
+            break;
+        }
+    }
+
+    return ops;
+}
+
+/* All the invariants of a B-tree: sorted keys equal to the reference, every
+   node but the root holds B-1 to 2B-1 keys, and all leaves are at the same
+   depth. */
+template<size_t B>
+static void check_invariants(const BTree<int, B>& btree, const std::set<int>& ref) {
+    if (!std::equal(btree.begin(), btree.end(), ref.begin(), ref.end()))
+        fail("in-order traversal", 0, B);
+
+    size_t depth = btree.depth().value_or(0);
+    btree.for_each_level([depth](size_t lv, const auto& nodes) {
+        for (auto node : nodes) {
+            if (node->n > 2 * B - 1 || (lv > 0 && node->n < B - 1))
+                fail("node utilization", (int)lv, B);
+            if ((node->type == NodeType::LEAF) != (lv == depth))
+                fail("perfect balance", (int)lv, B);
+        }
+    });
+}
 
-    SHA1((unsigned char*) data, size, cs);
+template<size_t B>
+static void run_differential(const std::vector<Op>& ops) {
+    BTree<int, B> btree;
+    std::set<int> ref;
 
-    for (auto i = 0; i < 20; i++) {
-        btree.insert(cs[i]);
-        ds.push_back(cs[i]);
+    for (const auto& op : ops) {
+        switch (op.kind) {
+        case OpKind::INSERT:
+            if (btree.insert(op.key) != ref.insert(op.key).second)
+                fail("insert", op.key, B);
+            break;
+        case OpKind::REMOVE:
+            if (btree.remove(op.key) != (ref.erase(op.key) == 1))
+                fail("remove", op.key, B);
+            break;
+        case OpKind::CONTAINS:
+            if (btree.contains(op.key) != (ref.count(op.key) == 1))
+                fail("contains", op.key, B);
+            break;
+        case OpKind::CHECK:
+            check_invariants(btree, ref);
+            break;
+        }
     }
 
-    std::random_device rd;
-    std::mt19937 g(rd());
+    check_invariants(btree, ref);
+}
+
+/* Run the operations on the BTree alone, and return operations per second */
+template<size_t B>
+static double run_timed(const std::vector<Op>& ops) {
+    BTree<int, B> btree;
+    size_t hits = 0;
 
-    std::shuffle(ds.begin(), ds.end(), g);
+    auto start = std::chrono::steady_clock::now();
+    for (const auto& op : ops) {
+        switch (op.kind) {
+        case OpKind::INSERT:
+            hits += btree.insert(op.key);
+            break;
+        case OpKind::REMOVE:
+            hits += btree.remove(op.key);
+            break;
+        case OpKind::CONTAINS:
+            hits += btree.contains(op.key);
+            break;
+        case OpKind::CHECK:
+            break;
+        }
+    }
+    std::chrono::duration<double> secs = std::chrono::steady_clock::now() - start;
 
-    for (auto i = 0; i < 20; i++)
-        btree.remove(ds[i]);
+    /* Keep the results alive */
+    if (hits == ~size_t{0})
+        fputs("", stderr);
+
+    return ops.size() / secs.count();
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    auto ops = decode(data, size);
+
+    run_differential<2>(ops);
+    run_differential<3>(ops);
+    run_differential<6>(ops);
+    run_differential<16>(ops);
 
     return 0;
 }
+
+#ifndef BTREE_FUZZ_LIBFUZZER
+
+static std::vector<Op> generate(size_t num_ops, unsigned seed) {
+    std::mt19937 g(seed);
+    std::uniform_int_distribution<int> keys(0, std::max<int>(1, num_ops / 2));
+    std::uniform_int_distribution<int> kinds(0, 9);
+    std::vector<Op> ops;
+
+    for (size_t i = 0; i < num_ops; i++) {
+        int k = kinds(g);
+        OpKind kind = k < 4 ? OpKind::INSERT :
+            k < 7 ? OpKind::REMOVE : OpKind::CONTAINS;
+        ops.push_back({ kind, keys(g) });
+    }
+
+    /* A few full checks along the way */
+    for (size_t i = 1; i <= 4; i++)
+        ops.insert(ops.begin() + i * num_ops / 5, Op{ OpKind::CHECK, 0 });
+
+    return ops;
+}
+
+template<size_t B>
+static void report(const char* input, const std::vector<Op>& ops) {
+    run_differential<B>(ops);
+    printf("%-32s B = %2zu %10zu ops %12.0f ops/s\n",
+           input, B, ops.size(), run_timed<B>(ops));
+}
+
+static void run_all(const char* input, const std::vector<Op>& ops) {
+    report<2>(input, ops);
+    report<3>(input, ops);
+    report<6>(input, ops);
+    report<16>(input, ops);
+}
+
+int main(int argc, char *argv[]) {
+    size_t num_ops = 1'000'000;
+    unsigned seed = 0;
+    std::vector<std::string> files;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "-n" && i + 1 < argc)
+            num_ops = std::stoul(argv[++i]);
+        else if (arg == "-s" && i + 1 < argc)
+            seed = std::stoul(argv[++i]);
+        else
+            files.push_back(arg);
+    }
+
+    if (files.empty()) {
+        run_all("random", generate(num_ops, seed));
+        return 0;
+    }
+
+    for (const auto& file : files) {
+        std::ifstream in(file, std::ios::binary);
+        std::vector<uint8_t> data{ std::istreambuf_iterator<char>(in),
+                                   std::istreambuf_iterator<char>() };
+        run_all(file.c_str(), decode(data.data(), data.size()));
+    }
+
+    return 0;
+}
+
+#endif
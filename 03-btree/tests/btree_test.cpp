@@ -2,6 +2,7 @@
 #include <iterator>
 #include <vector>
 #include <random>
+#include <set>
 
 #include "btree.hpp"
 
@@ -152,3 +153,154 @@ TEST_CASE("Perfect balance") {
                             return n->type == NodeType::LEAF;
                         }));
 }
+
+TEST_CASE("Batched insert and lookup", "[btree]") {
+    static constexpr size_t B = 3;
+    BTree<int, B> btree;
+    std::set<int> ref;
+
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> dist(0, 200'000);
+
+    /* An empty batch leaves an empty tree empty */
+    REQUIRE(btree.insert_batch({}) == 0);
+    REQUIRE(!btree.depth().has_value());
+
+    for (auto round = 0; round < 50; round++) {
+        std::vector<int> batch;
+        for (auto i = 0; i < 2'000; i++)
+            batch.push_back(dist(g));
+
+        size_t expected = 0;
+        for (auto x : batch)
+            expected += ref.insert(x).second;
+
+        REQUIRE(btree.insert_batch(batch) == expected);
+    }
+
+    std::vector<int> xs;
+    btree.for_all([&xs](int& i){ xs.push_back(i); });
+    REQUIRE(std::equal(xs.begin(), xs.end(), ref.begin(), ref.end()));
+
+    /* Still a valid B-tree: every leaf at the same depth */
+    auto depth = btree.depth().value();
+    for (auto node : btree.root->find_nodes_at_level(depth))
+        REQUIRE(node->type == NodeType::LEAF);
+
+    std::vector<int> queries;
+    for (auto i = 0; i < 10'000; i++)
+        queries.push_back(dist(g));
+
+    auto found = btree.find_batch(queries);
+    for (auto i = 0; i < queries.size(); i++) {
+        REQUIRE(found[i] == (ref.count(queries[i]) == 1));
+        REQUIRE(btree.contains(queries[i]) == found[i]);
+    }
+}
+
+TEST_CASE("In-order iterator", "[btree]") {
+    BTree<int, 3> btree;
+    std::vector<int> xs, ys;
+
+    REQUIRE(btree.begin() == btree.end());
+
+    std::mt19937 g(0);
+    for (auto i = 1; i <= 50'000; i++)
+        xs.push_back(i);
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    for (auto x : xs)
+        btree.insert(x);
+
+    for (auto it = btree.begin(); it != btree.end(); ++it)
+        ys.push_back(*it);
+
+    std::sort(xs.begin(), xs.end());
+    REQUIRE(xs == ys);
+
+    /* Range-for and standard algorithms work on the tree */
+    long sum = 0;
+    for (const auto& k : btree)
+        sum += k;
+    REQUIRE(sum == 50'000L * 50'001 / 2);
+    REQUIRE(std::is_sorted(btree.begin(), btree.end()));
+}
+
+TEST_CASE("Level-order formatting and statistics", "[btree]") {
+    static constexpr size_t B = 4;
+    BTree<int, B> btree;
+    size_t n = 20'000;
+
+    REQUIRE(btree.format().empty());
+    REQUIRE(btree.stats().num_keys == 0);
+
+    std::vector<int> xs;
+    for (auto i = 1; i <= n; i++)
+        xs.push_back(i);
+
+    std::mt19937 g(0);
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    for (auto x : xs)
+        btree.insert(x);
+
+    /* Same output as formatting each level separately */
+    auto depth = btree.depth().value();
+    REQUIRE(btree.format() == btree.root->format_subtree(depth));
+
+    auto st = btree.stats();
+    REQUIRE(st.depth == depth);
+    REQUIRE(st.num_keys == n);
+    REQUIRE(st.levels.size() == depth + 1);
+
+    for (auto lv = 0; lv <= depth; lv++) {
+        auto nodes = btree.root->find_nodes_at_level(lv);
+        REQUIRE(st.levels[lv].num_nodes == nodes.size());
+        REQUIRE(st.levels[lv].capacity == nodes.size() * (2 * B - 1));
+
+        /* Every node but the root is at least half full */
+        if (lv > 0)
+            REQUIRE(st.levels[lv].fill_factor() >= (double)(B - 1) / (2 * B - 1));
+    }
+}
+
+TEST_CASE("Node pool", "[btree]") {
+    static constexpr size_t B = 2;
+    size_t n = 10'000;
+
+    SECTION("nodes come from a few chunks") {
+        BTree<int, B> btree;
+        for (auto i = 0; i < n; i++)
+            btree.insert(i);
+
+        const auto& st = btree.pool.get_stats();
+        REQUIRE(st.allocations == btree.stats().num_nodes);
+        REQUIRE(st.capacity >= st.allocations);
+        REQUIRE(st.chunks < 16);
+
+        /* A cleared tree can be filled again */
+        btree.clear();
+        REQUIRE(btree.root == nullptr);
+        REQUIRE(btree.pool.get_stats().capacity == 0);
+
+        for (auto i = 0; i < n; i++)
+            btree.insert(i);
+        REQUIRE(std::distance(btree.begin(), btree.end()) == n);
+    }
+
+    SECTION("keys that are not trivially destructible") {
+        BTree<std::string, B> btree;
+        std::vector<std::string> xs, ys;
+
+        for (auto i = 0; i < n; i++)
+            xs.push_back("a key that does not fit in the small string buffer "
+                         + std::to_string(i));
+
+        for (const auto& x : xs)
+            btree.insert(x);
+
+        btree.for_all([&ys](std::string& s) { ys.push_back(s); });
+        std::sort(xs.begin(), xs.end());
+        REQUIRE(xs == ys);
+    }
+}
@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <atomic>
+#include <iterator>
+#include <thread>
+#include <vector>
+#include <random>
+
+#include "concurrent_btree.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+static constexpr size_t NUM_THREADS = 4;
+
+TEST_CASE("Concurrent inserts of disjoint keys", "[concurrent_btree]") {
+    ConcurrentBTree<int, 2> tree;
+    size_t N = 50'000;
+    std::vector<std::thread> threads;
+    std::atomic<bool> ok{true};
+
+    for (size_t t = 0; t < NUM_THREADS; t++) {
+        threads.emplace_back([&tree, &ok, t, N] {
+            std::vector<int> xs;
+            for (size_t i = 0; i < N; i++)
+                xs.push_back(i * NUM_THREADS + t);
+
+            std::mt19937 g(t);
+            std::shuffle(xs.begin(), xs.end(), g);
+
+            for (auto x : xs) {
+                /* A key is visible right after its insertion returns */
+                if (!tree.insert(x) || !tree.contains(x))
+                    ok = false;
+            }
+        });
+    }
+
+    for (auto& th : threads)
+        th.join();
+
+    REQUIRE(ok);
+
+    std::vector<int> xs, ys;
+    for (size_t i = 0; i < N * NUM_THREADS; i++)
+        xs.push_back(i);
+
+    tree.for_all([&ys](const int& i) { ys.push_back(i); });
+
+    REQUIRE(xs == ys);
+}
+
+TEST_CASE("Readers during concurrent inserts", "[concurrent_btree]") {
+    ConcurrentBTree<int> tree;
+    size_t N = 200'000;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> false_positives{0}, misses{0};
+
+    /* Even keys are present from the start, odd keys are never inserted */
+    for (size_t i = 0; i < N; i += 2)
+        tree.insert(i);
+
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < NUM_THREADS - 1; t++) {
+        readers.emplace_back([&, t] {
+            std::mt19937 g(t);
+            std::uniform_int_distribution<int> dist(0, N - 1);
+
+            while (!done) {
+                int x = dist(g);
+                bool found = tree.contains(x);
+                if (x % 2 == 0 && !found)
+                    misses++;
+                if (x % 2 != 0 && found)
+                    false_positives++;
+            }
+        });
+    }
+
+    /* Insert keys beyond N, splitting nodes under the readers */
+    std::vector<int> xs;
+    for (size_t i = N; i < 4 * N; i += 2)
+        xs.push_back(i);
+
+    std::mt19937 g(0);
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    for (auto x : xs)
+        REQUIRE(tree.insert(x));
+
+    done = true;
+    for (auto& th : readers)
+        th.join();
+
+    REQUIRE(misses == 0);
+    REQUIRE(false_positives == 0);
+}
@@ -0,0 +1,107 @@
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <vector>
+#include <random>
+#include <set>
+
+#include "disk_btree.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+static std::string temp_path(const std::string& name) {
+    auto path = std::filesystem::temp_directory_path() / name;
+    std::filesystem::remove(path);
+    return path.string();
+}
+
+TEST_CASE("Insert and find with a small buffer pool", "[disk_btree]") {
+    auto path = temp_path("disk_btree_test_find.db");
+    std::vector<int> xs;
+    size_t N = 100'000;
+
+    for (auto i = 1; i <= N; i++)
+        xs.push_back(2 * i);
+
+    std::random_device rd;
+    std::mt19937 g(rd());
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    {
+        /* 8 frames are far fewer than the pages of the tree */
+        DiskBTree<int, 16> tree(path, 8);
+
+        for (auto x : xs)
+            REQUIRE(tree.insert(x));
+        REQUIRE_FALSE(tree.insert(xs[0]));
+        REQUIRE(tree.get_size() == N);
+
+        for (auto x : xs) {
+            REQUIRE(tree.find(x));
+            REQUIRE_FALSE(tree.find(x + 1));
+        }
+
+        REQUIRE(tree.get_pool_stats().evictions > 0);
+    }
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Range scan", "[disk_btree]") {
+    auto path = temp_path("disk_btree_test_scan.db");
+    DiskBTree<int, 4> tree(path, 16);
+    std::set<int> ref;
+
+    std::mt19937 g(42);
+    std::uniform_int_distribution<int> dist(0, 1'000'000);
+
+    for (auto i = 0; i < 50'000; i++) {
+        auto x = dist(g);
+        REQUIRE(tree.insert(x) == ref.insert(x).second);
+    }
+
+    for (auto i = 0; i < 100; i++) {
+        auto lo = dist(g), hi = lo + dist(g) / 10;
+        std::vector<int> xs, ys;
+
+        tree.scan(lo, hi, [&xs](const int& k) { xs.push_back(k); });
+        std::copy(ref.lower_bound(lo), ref.upper_bound(hi),
+                  std::back_inserter(ys));
+
+        REQUIRE(xs == ys);
+    }
+
+    std::vector<int> all;
+    tree.scan(0, 1'000'000, [&all](const int& k) { all.push_back(k); });
+    REQUIRE(std::equal(all.begin(), all.end(), ref.begin(), ref.end()));
+
+    std::filesystem::remove(path);
+}
+
+TEST_CASE("Reopen a tree file", "[disk_btree]") {
+    auto path = temp_path("disk_btree_test_reopen.db");
+    size_t N = 20'000;
+
+    {
+        DiskBTree<long> tree(path, 4);
+        for (long i = 0; i < N; i++)
+            tree.insert(i * 3);
+    }
+
+    {
+        DiskBTree<long> tree(path, 4);
+        REQUIRE(tree.get_size() == N);
+        REQUIRE(tree.depth().has_value());
+
+        for (long i = 0; i < N; i++) {
+            REQUIRE(tree.find(i * 3));
+            REQUIRE_FALSE(tree.find(i * 3 + 1));
+        }
+
+        REQUIRE(tree.insert(N * 3));
+        REQUIRE(tree.find(N * 3));
+    }
+
+    std::filesystem::remove(path);
+}
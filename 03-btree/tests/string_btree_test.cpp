@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <iterator>
+#include <vector>
+#include <random>
+#include <set>
+#include <string>
+
+#include "string_btree.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+static std::string make_url(std::mt19937& g) {
+    static const char* hosts[] = { "https://www.example.com/",
+                                   "https://www.example.org/",
+                                   "http://shop.example.com/" };
+    std::uniform_int_distribution<int> dist(0, 999);
+
+    std::string url = hosts[dist(g) % 3];
+    url += "category/" + std::to_string(dist(g) % 20);
+    url += "/item/" + std::to_string(dist(g));
+    if (dist(g) % 2)
+        url += "?ref=" + std::to_string(dist(g));
+    return url;
+}
+
+TEST_CASE("Insert and lookup URLs", "[string_btree]") {
+    StringBTree<4> tree;
+    std::set<std::string> ref;
+    std::mt19937 g(0);
+
+    for (auto i = 0; i < 50'000; i++) {
+        auto url = make_url(g);
+        REQUIRE(tree.insert(url) == ref.insert(url).second);
+    }
+
+    REQUIRE(tree.get_size() == ref.size());
+
+    std::vector<std::string> xs;
+    tree.for_all([&xs](const std::string& k) { xs.push_back(k); });
+    REQUIRE(std::equal(xs.begin(), xs.end(), ref.begin(), ref.end()));
+
+    for (const auto& k : ref)
+        REQUIRE(tree.contains(k));
+
+    for (auto i = 0; i < 10'000; i++) {
+        auto url = make_url(g);
+        REQUIRE(tree.contains(url) == (ref.count(url) == 1));
+    }
+}
+
+TEST_CASE("Keys that are prefixes of each other", "[string_btree]") {
+    StringBTree<2> tree;
+    std::set<std::string> ref;
+
+    /* "", "a", "aa", ..., and then the same with a trailing "b" */
+    for (auto len = 0; len < 200; len++) {
+        std::string k(len, 'a');
+        REQUIRE(tree.insert(k) == ref.insert(k).second);
+        REQUIRE(tree.insert(k + 'b') == ref.insert(k + 'b').second);
+        REQUIRE(tree.insert(k + '\xff') == ref.insert(k + '\xff').second);
+    }
+
+    std::vector<std::string> xs;
+    tree.for_all([&xs](const std::string& k) { xs.push_back(k); });
+    REQUIRE(std::equal(xs.begin(), xs.end(), ref.begin(), ref.end()));
+
+    REQUIRE_FALSE(tree.insert(""));
+    REQUIRE(tree.contains(std::string(199, 'a')));
+    REQUIRE_FALSE(tree.contains(std::string(200, 'a')));
+    REQUIRE_FALSE(tree.contains("abb"));
+    REQUIRE_FALSE(tree.contains("c"));
+}
+
+TEST_CASE("Shared prefixes are stored once per node", "[string_btree]") {
+    StringBTree<16> tree;
+    std::string prefix(200, '/');
+    size_t n = 10'000;
+
+    for (auto i = 0; i < n; i++)
+        tree.insert(prefix + std::to_string(i));
+
+    /* Far less than one copy of the prefix per key */
+    REQUIRE(tree.memory_usage() < n * prefix.size() / 3);
+}
@@ -0,0 +1,38 @@
+#ifndef _ALLOC_COUNTER_HPP
+#define _ALLOC_COUNTER_HPP
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#include <malloc.h>
+
+/* Replaces the global operator new and delete to count heap allocations
+ * and live heap bytes, for the benchmarks that report memory. It defines
+ * the operators, so only one source file of a program may include it.
+ *
+ * The operators are not inlined: GCC would otherwise see free() on memory
+ * from operator new and warn (-Wmismatched-new-delete). */
+
+static size_t num_allocs = 0;
+static long live_bytes = 0;
+
+__attribute__((noinline)) void* operator new(size_t size) {
+    if (void* p = std::malloc(size ? size : 1)) {
+        num_allocs++;
+        live_bytes += malloc_usable_size(p);
+        return p;
+    }
+    throw std::bad_alloc{};
+}
+
+__attribute__((noinline)) void operator delete(void* p) noexcept {
+    live_bytes -= malloc_usable_size(p);
+    std::free(p);
+}
+
+__attribute__((noinline)) void operator delete(void* p, size_t) noexcept {
+    operator delete(p);
+}
+
+#endif
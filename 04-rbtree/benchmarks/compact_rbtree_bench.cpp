@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "rbtree.hpp"
+#include "compact_rbtree.hpp"
+#include "alloc_counter.hpp"
+
+/* Usage: compact_rbtree_bench [num_keys] [num_lookups]
+ *
+ * Memory per key and lookup latency of RBTree, CompactRBTree and std::set,
+ * built from the same random int keys. Memory is the growth of live heap
+ * bytes while building the tree. Only one tree is alive at a time. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Tree, typename Build, typename Find>
+static void run(const char* name, const std::vector<int>& keys,
+                const std::vector<int>& lookups, Build&& build, Find&& find) {
+    long before = live_bytes;
+    size_t hits = 0;
+
+    auto start = Clock::now();
+    {
+        Tree tree;
+        build(tree);
+        double build_secs = std::chrono::duration<double>(Clock::now() - start).count();
+        double bytes_per_key = double(live_bytes - before) / keys.size();
+
+        start = Clock::now();
+        for (auto x : lookups)
+            hits += find(tree, x);
+        double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+        printf("%-22s %8.1f B/key %8.1f ns/lookup %8.2f s build  (%zu hits)\n",
+               name, bytes_per_key, ns / lookups.size(), build_secs, hits);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 100'000'000;
+    size_t num_lookups = argc > 2 ? std::stoul(argv[2]) : 10'000'000;
+
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> dist;
+    std::vector<int> keys(n), lookups(num_lookups);
+
+    for (auto& k : keys)
+        k = dist(g);
+    for (auto& k : lookups)
+        k = keys[g() % n];
+
+    printf("%zu keys, %zu lookups\n", n, num_lookups);
+
+    run<CompactRBTree<int>>("CompactRBTree<int>", keys, lookups,
+        [&keys](CompactRBTree<int>& t) {
+            t.reserve(keys.size());
+            for (auto k : keys)
+                t.insert(k);
+        },
+        [](const CompactRBTree<int>& t, int x) { return t.contains(x); });
+
+    run<RBTree<int>>("RBTree<int>", keys, lookups,
+        [&keys](RBTree<int>& t) {
+            for (auto k : keys)
+                t.insert(k);
+        },
+        [](RBTree<int>& t, int x) { return t.contains(x); });
+
+    run<std::set<int>>("std::set<int>", keys, lookups,
+        [&keys](std::set<int>& t) {
+            for (auto k : keys)
+                t.insert(k);
+        },
+        [](const std::set<int>& t, int x) { return t.count(x) == 1; });
+
+    return 0;
+}
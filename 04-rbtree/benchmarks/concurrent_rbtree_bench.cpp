@@ -0,0 +1,120 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <mutex>
+#include <random>
+#include <shared_mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rbtree.hpp"
+#include "concurrent_rbtree.hpp"
+
+/* Usage: concurrent_rbtree_bench [num_keys] [max_threads] [write_permille] [millis]
+ *
+ * Read scaling of ConcurrentRBTree against RBTree behind a
+ * std::shared_mutex, for 1, 2, 4, ... up to max_threads threads. Every
+ * thread runs random operations for a fixed time: write_permille out of a
+ * thousand are an insert or a remove, the rest are lookups. */
+
+using Clock = std::chrono::steady_clock;
+
+struct LockedRBTree {
+    RBTree<int> tree;
+    mutable std::shared_mutex lock;
+
+    bool contains(int x) const {
+        std::shared_lock<std::shared_mutex> guard(lock);
+        return const_cast<RBTree<int>&>(tree).contains(x);
+    }
+    bool insert(int x) {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        return tree.insert(x);
+    }
+    bool remove(int x) {
+        std::unique_lock<std::shared_mutex> guard(lock);
+        return tree.remove(x);
+    }
+};
+
+/* Returns millions of operations per second */
+template<typename Tree>
+static double run(Tree& tree, size_t num_threads, int max_key,
+                  unsigned write_permille, unsigned millis) {
+    std::atomic<bool> start{false}, stop{false};
+    std::atomic<size_t> total_ops{0}, hits{0};
+    std::vector<std::thread> threads;
+
+    for (size_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&, t] {
+            std::mt19937 g(t);
+            std::uniform_int_distribution<int> keys(0, max_key);
+            std::uniform_int_distribution<unsigned> permille(0, 999);
+            size_t ops = 0, found = 0;
+
+            while (!start)
+                std::this_thread::yield();
+
+            while (!stop.load(std::memory_order_relaxed)) {
+                for (int i = 0; i < 64; i++, ops++) {
+                    int x = keys(g);
+                    unsigned p = permille(g);
+                    if (p >= write_permille)
+                        found += tree.contains(x);
+                    else if (p % 2 == 0)
+                        found += tree.insert(x);
+                    else
+                        found += tree.remove(x);
+                }
+            }
+
+            total_ops += ops;
+            hits += found;
+        });
+    }
+
+    auto begin = Clock::now();
+    start = true;
+    std::this_thread::sleep_for(std::chrono::milliseconds(millis));
+    stop = true;
+    for (auto& th : threads)
+        th.join();
+    double secs = std::chrono::duration<double>(Clock::now() - begin).count();
+
+    if (hits == ~size_t{0})
+        puts("");
+
+    return total_ops / secs / 1e6;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    size_t max_threads = argc > 2 ? std::stoul(argv[2]) : 64;
+    unsigned write_permille = argc > 3 ? std::stoul(argv[3]) : 10;
+    unsigned millis = argc > 4 ? std::stoul(argv[4]) : 1'000;
+
+    /* Keys come from twice the initial size, so half of the lookups hit */
+    int max_key = 2 * n;
+    ConcurrentRBTree<int> concurrent;
+    LockedRBTree locked;
+
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> keys(0, max_key);
+    for (size_t i = 0; i < n; i++) {
+        int x = keys(g);
+        concurrent.insert(x);
+        locked.insert(x);
+    }
+
+    printf("%zu keys, %u/1000 writes, %u ms per run\n", n, write_permille, millis);
+    printf("%-8s %20s %20s\n", "threads", "ConcurrentRBTree", "RBTree+shared_mutex");
+
+    for (size_t t = 1; t <= max_threads; t *= 2) {
+        double c = run(concurrent, t, max_key, write_permille, millis);
+        double l = run(locked, t, max_key, write_permille, millis);
+        printf("%-8zu %15.2f Mop/s %15.2f Mop/s\n", t, c, l);
+    }
+
+    return 0;
+}
@@ -0,0 +1,102 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rbmap.hpp"
+
+/* Usage: rbmap_bench [num_keys]
+ *
+ * The same sequence of map operations on RBMap and std::map: insertion of
+ * random keys, successful and failed lookups, lower_bound, a full
+ * iteration, operator[] updates, and erasure. Prints nanoseconds per
+ * operation for each phase. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Func>
+static double ns_per_op(size_t n, Func&& func) {
+    auto start = Clock::now();
+    func();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+template<typename Map, typename Insert, typename Key>
+static std::vector<double> run(const std::vector<int>& keys,
+                               const std::vector<int>& probes,
+                               Insert&& insert, Key&& key, long& sink) {
+    Map map;
+    size_t n = keys.size();
+    std::vector<double> ns;
+
+    ns.push_back(ns_per_op(n, [&] {
+        for (auto k : keys)
+            insert(map, k);
+    }));
+    ns.push_back(ns_per_op(n, [&] {
+        for (auto k : keys)
+            sink += map.find(k) != map.end();
+    }));
+    ns.push_back(ns_per_op(n, [&] {
+        for (auto k : probes)
+            sink += map.find(k) != map.end();
+    }));
+    ns.push_back(ns_per_op(n, [&] {
+        for (auto k : probes) {
+            auto it = map.lower_bound(k);
+            sink += it != map.end() ? key(it) : 0;
+        }
+    }));
+    ns.push_back(ns_per_op(n, [&] {
+        for (auto it = map.begin(); it != map.end(); ++it)
+            sink += key(it);
+    }));
+    ns.push_back(ns_per_op(n, [&] {
+        for (auto k : keys)
+            map[k]++;
+    }));
+    ns.push_back(ns_per_op(n, [&] {
+        for (auto k : keys)
+            sink += map.erase(k);
+    }));
+
+    return ns;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+
+    /* Even keys are inserted, odd probes always miss */
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> dist(0, 1 << 29);
+    std::vector<int> keys(n), probes(n);
+    for (size_t i = 0; i < n; i++) {
+        keys[i] = 2 * dist(g);
+        probes[i] = 2 * dist(g) + 1;
+    }
+
+    long sink = 0;
+
+    auto rb = run<RBMap<int, long>>(keys, probes,
+        [](RBMap<int, long>& m, int k) { m.insert(k, k); },
+        [](const RBMap<int, long>::iterator& it) { return it->key; }, sink);
+
+    auto stl = run<std::map<int, long>>(keys, probes,
+        [](std::map<int, long>& m, int k) { m.insert({ k, k }); },
+        [](const std::map<int, long>::iterator& it) { return it->first; }, sink);
+
+    static const char* phases[] = {
+        "insert", "find (hit)", "find (miss)", "lower_bound", "iterate",
+        "operator[]", "erase",
+    };
+
+    printf("%zu keys (%ld)\n", n, sink);
+    printf("%-14s %14s %14s\n", "ns/op", "RBMap", "std::map");
+    for (size_t i = 0; i < rb.size(); i++)
+        printf("%-14s %14.1f %14.1f\n", phases[i], rb[i], stl[i]);
+
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "rbtree.hpp"
+
+/* Usage: rbtree_bench [num_keys]
+ *
+ * Inserts num_keys random keys into RBTree and std::set, looks them all up,
+ * and removes them all in another random order. Prints nanoseconds per
+ * operation for each phase. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Func>
+static double ns_per_op(size_t n, Func&& func) {
+    auto start = Clock::now();
+    func();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+
+    std::vector<int> xs(n), ys;
+    for (size_t i = 0; i < n; i++)
+        xs[i] = i;
+
+    std::mt19937 g(0);
+    std::shuffle(xs.begin(), xs.end(), g);
+    ys = xs;
+    std::shuffle(ys.begin(), ys.end(), g);
+
+    size_t hits = 0;
+    RBTree<int> rbtree;
+    std::set<int> set;
+
+    double rb_insert = ns_per_op(n, [&] {
+        for (auto x : xs)
+            hits += rbtree.insert(x);
+    });
+    double rb_find = ns_per_op(n, [&] {
+        for (auto y : ys)
+            hits += rbtree.contains(y);
+    });
+    double rb_remove = ns_per_op(n, [&] {
+        for (auto y : ys)
+            hits += rbtree.remove(y);
+    });
+
+    double set_insert = ns_per_op(n, [&] {
+        for (auto x : xs)
+            hits += set.insert(x).second;
+    });
+    double set_find = ns_per_op(n, [&] {
+        for (auto y : ys)
+            hits += set.count(y);
+    });
+    double set_remove = ns_per_op(n, [&] {
+        for (auto y : ys)
+            hits += set.erase(y);
+    });
+
+    printf("%zu keys (%zu hits)\n", n, hits);
+    printf("%-14s %10s %10s %10s\n", "ns/op", "insert", "find", "remove");
+    printf("%-14s %10.1f %10.1f %10.1f\n", "RBTree<int>", rb_insert, rb_find, rb_remove);
+    printf("%-14s %10.1f %10.1f %10.1f\n", "std::set<int>", set_insert, set_find, set_remove);
+
+    return 0;
+}
@@ -0,0 +1,58 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rbtree.hpp"
+
+/* Usage: rbtree_export_bench [num_keys] [output]
+ *
+ * Builds an RBTree of num_keys random keys (1M by default) and times
+ * write_graphviz() and write_json() streaming to output (/dev/null by
+ * default), and format_graphviz() building the whole dump as a string.
+ * Prints milliseconds and megabytes written for each. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Func>
+static double ms(Func&& func) {
+    auto start = Clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    std::string output = argc > 2 ? argv[2] : "/dev/null";
+
+    std::vector<int> xs(n);
+    for (size_t i = 0; i < n; i++)
+        xs[i] = i;
+
+    std::mt19937 g(0);
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    RBTree<int> rbtree;
+    for (auto x : xs)
+        rbtree.insert(x);
+
+    std::ofstream out(output);
+    std::streamoff bytes = 0;
+
+    double dot_ms = ms([&] { rbtree.write_graphviz(out); out.flush(); });
+    bytes = out.tellp();
+    printf("%-24s %10.1f ms %8.1f MB\n", "write_graphviz()", dot_ms, bytes / 1e6);
+
+    double json_ms = ms([&] { rbtree.write_json(out); out.flush(); });
+    printf("%-24s %10.1f ms %8.1f MB\n", "write_json()", json_ms,
+           (out.tellp() - bytes) / 1e6);
+
+    std::string dot;
+    double str_ms = ms([&] { dot = rbtree.format_graphviz(); });
+    printf("%-24s %10.1f ms %8.1f MB\n", "format_graphviz()", str_ms, dot.size() / 1e6);
+
+    return 0;
+}
@@ -0,0 +1,111 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "rbtree.hpp"
+
+/* Usage: rbtree_hint_bench [num_keys] [window]
+ *
+ * Ingests num_keys timestamps that arrive nearly sorted: every key is at
+ * most `window` positions (16 by default) away from its sorted place. Each
+ * set is filled with a plain insert and with an insert hinted by the
+ * previous key, as std::set::emplace_hint allows, then all the keys are
+ * looked up in order with and without hints. Fully sorted and random
+ * inputs are shown for reference. Prints nanoseconds per operation. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Func>
+static double ns_per_op(size_t n, Func&& func) {
+    auto start = Clock::now();
+    func();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+static void run(const char* name, const std::vector<long>& xs, size_t& sink) {
+    size_t n = xs.size();
+    double ns[6];
+
+    {
+        RBTree<long> rbtree;
+        ns[0] = ns_per_op(n, [&] {
+            for (auto x : xs)
+                sink += rbtree.insert(x);
+        });
+    }
+    {
+        RBTree<long> rbtree;
+        ns[1] = ns_per_op(n, [&] {
+            auto hint = rbtree.end();
+            for (auto x : xs)
+                hint = rbtree.insert(std::move(hint), x);
+        });
+
+        ns[4] = ns_per_op(n, [&] {
+            for (auto x : xs)
+                sink += rbtree.contains(x);
+        });
+        ns[5] = ns_per_op(n, [&] {
+            auto hint = rbtree.end();
+            for (auto x : xs) {
+                hint = rbtree.find(std::move(hint), x);
+                sink += *hint == x;
+            }
+        });
+    }
+    {
+        std::set<long> set;
+        ns[2] = ns_per_op(n, [&] {
+            for (auto x : xs)
+                sink += set.insert(x).second;
+        });
+    }
+    {
+        std::set<long> set;
+        ns[3] = ns_per_op(n, [&] {
+            auto hint = set.end();
+            for (auto x : xs)
+                hint = set.emplace_hint(hint, x);
+        });
+        sink += set.size();
+    }
+
+    printf("%-14s %12.1f %12.1f %12.1f %12.1f %12.1f %12.1f\n",
+           name, ns[0], ns[1], ns[2], ns[3], ns[4], ns[5]);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1'000'000;
+    size_t window = argc > 2 ? std::stoul(argv[2]) : 16;
+
+    std::mt19937 g(0);
+    std::vector<long> sorted(n), nearly, random;
+    for (size_t i = 0; i < n; i++)
+        sorted[i] = 1'000 * i;
+
+    /* Shuffle within consecutive windows */
+    nearly = sorted;
+    for (size_t i = 0; i < n; i += window)
+        std::shuffle(nearly.begin() + i, nearly.begin() + std::min(n, i + window), g);
+
+    random = sorted;
+    std::shuffle(random.begin(), random.end(), g);
+
+    size_t sink = 0;
+
+    printf("%-14s %12s %12s %12s %12s %12s %12s\n", "ns/op", "rb insert",
+           "rb hinted", "set insert", "set hinted", "rb find", "rb hinted");
+    run("sorted", sorted, sink);
+    run("nearly sorted", nearly, sink);
+    run("random", random, sink);
+
+    /* Keep the results alive */
+    if (sink == 0)
+        fputs("", stderr);
+
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "rbtree_setops.hpp"
+
+/* Usage: rbtree_setops_bench [n] [m] [max_threads]
+ *
+ * Union, intersection and difference of random sets of n and m keys, for
+ * 1, 2, 4, ... up to max_threads threads, against the insert/remove loop
+ * over the smaller set. About half of the keys of the smaller set are also
+ * in the larger one. The input trees are rebuilt before every run, and the
+ * result is freed after it; neither is timed. Intersection does free the
+ * nodes of the inputs that it drops, which is linear in their number. */
+
+using Clock = std::chrono::steady_clock;
+
+/* Build a tree from sorted keys in linear time, by joining halves */
+static RBSubtree<int> build(const int* first, const int* last) {
+    if (first == last)
+        return {};
+
+    const int* mid = first + (last - first) / 2;
+    return rbtree_setops::join(build(first, mid),
+                               std::make_unique<RBNode<int>>(*mid),
+                               build(mid + 1, last));
+}
+
+static RBTree<int> make_tree(const std::vector<int>& sorted_keys) {
+    return rbtree_setops::to_tree(build(sorted_keys.data(),
+                                        sorted_keys.data() + sorted_keys.size()));
+}
+
+template<typename Func>
+static double millis(Func&& func) {
+    auto start = Clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 4'000'000;
+    size_t m = argc > 2 ? std::stoul(argv[2]) : 4'000'000;
+    size_t max_threads = argc > 3 ? std::stoul(argv[3])
+                                  : std::max(1u, std::thread::hardware_concurrency());
+
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> dist(0, 1 << 30);
+    std::vector<int> xs(n), ys(m);
+    for (auto& x : xs)
+        x = dist(g);
+    for (size_t i = 0; i < m; i++)
+        ys[i] = i % 2 == 0 && n > 0 ? xs[g() % n] : dist(g);
+
+    for (auto v : { &xs, &ys }) {
+        std::sort(v->begin(), v->end());
+        v->erase(std::unique(v->begin(), v->end()), v->end());
+    }
+
+    printf("|A| = %zu, |B| = %zu\n", xs.size(), ys.size());
+    printf("%-10s %12s %12s %12s\n", "ms", "union", "intersect", "difference");
+
+    const auto& small = xs.size() < ys.size() ? xs : ys;
+    const auto& large = xs.size() < ys.size() ? ys : xs;
+    size_t size = 0;
+
+    /* Today's way: one insert (or remove) per key of the smaller set */
+    double loop_union = 0, loop_diff = 0;
+    {
+        auto a = make_tree(large);
+        loop_union = millis([&] {
+            for (auto y : small)
+                a.insert(y);
+        });
+    }
+    {
+        auto a = make_tree(large);
+        loop_diff = millis([&] {
+            for (auto y : small)
+                a.remove(y);
+        });
+    }
+    printf("%-10s %12.1f %12s %12.1f\n", "loop", loop_union, "-", loop_diff);
+
+    for (size_t threads = 1; threads <= max_threads; threads *= 2) {
+        double ms[3];
+
+        {
+            auto a = make_tree(xs), b = make_tree(ys);
+            RBTree<int> c;
+            ms[0] = millis([&] {
+                c = rbtree_union(std::move(a), std::move(b), threads);
+            });
+            size += c.root != nullptr;
+        }
+        {
+            auto a = make_tree(xs), b = make_tree(ys);
+            RBTree<int> c;
+            ms[1] = millis([&] {
+                c = rbtree_intersection(std::move(a), std::move(b), threads);
+            });
+            size += c.root != nullptr;
+        }
+        {
+            auto a = make_tree(xs), b = make_tree(ys);
+            RBTree<int> c;
+            ms[2] = millis([&] {
+                c = rbtree_difference(std::move(a), std::move(b), threads);
+            });
+            size += c.root != nullptr;
+        }
+
+        std::string name = std::to_string(threads) + " thr";
+        printf("%-10s %12.1f %12.1f %12.1f\n", name.c_str(), ms[0], ms[1], ms[2]);
+    }
+
+    return size == ~size_t{0};
+}
@@ -0,0 +1,59 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "rbtree.hpp"
+
+/* Usage: rbtree_validate_bench [num_keys]
+ *
+ * Builds an RBTree of num_keys random keys (10M by default), then times
+ * validate() against the previous way of checking the tree in the tests:
+ * collecting every null link with its path through collect_all_leaves(),
+ * and comparing their black counts. Prints the statistics and the
+ * milliseconds taken by each. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Func>
+static double ms(Func&& func) {
+    auto start = Clock::now();
+    func();
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+
+    std::vector<int> xs(n);
+    for (size_t i = 0; i < n; i++)
+        xs[i] = i;
+
+    std::mt19937 g(0);
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    RBTree<int> rbtree;
+    for (auto x : xs)
+        rbtree.insert(x);
+    xs = std::vector<int>();
+
+    RBTreeStats st;
+    double validate_ms = ms([&] { st = rbtree.validate(); });
+
+    bool balanced = true;
+    double leaves_ms = ms([&] {
+        auto leaves = rbtree.collect_all_leaves();
+        size_t bh = leaves.begin()->first.num_black_;
+        for (const auto& [path, _] : leaves)
+            balanced &= path.num_black_ == bh;
+    });
+
+    printf("keys %zu, valid %d, black height %zu, max depth %zu, red %.3f\n",
+           st.size, st.valid, st.black_height, st.max_depth, st.red_ratio());
+    printf("%-24s %10.1f ms\n", "validate()", validate_ms);
+    printf("%-24s %10.1f ms (balanced %d)\n", "collect_all_leaves()", leaves_ms, balanced);
+
+    return 0;
+}
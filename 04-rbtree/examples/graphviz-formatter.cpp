@@ -2,13 +2,25 @@
 #include <vector>
 #include <algorithm>
 #include <bitset>
+#include <string>
 
 #include "rbtree.hpp"
 
+/* Usage: graphviz-formatter [--json] [num_keys] */
+
 int main(int argc, char *argv[]) {
     std::vector<int> xs{};
     RBTree<int> rbtree{};
     size_t N = 99;
+    bool json = false;
+
+    for (auto i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--json")
+            json = true;
+        else
+            N = std::stoul(arg);
+    }
 
     for (auto i = 1; i <= N; i++)
         xs.emplace_back(i);
@@ -21,7 +33,10 @@ int main(int argc, char *argv[]) {
     for (auto i : xs)
         rbtree.insert(i);
 
-    std::cout << rbtree.format_graphviz() << '\n';
+    if (json)
+        rbtree.write_json(std::cout);
+    else
+        rbtree.write_graphviz(std::cout);
 
     return 0;
 }
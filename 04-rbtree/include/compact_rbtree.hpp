@@ -0,0 +1,208 @@
+#ifndef __COMPACT_RBTREE_H_
+#define __COMPACT_RBTREE_H_
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "rbtree.hpp"
+
+/* A left-leaning red-black tree with a compact node layout.
+ *
+ * Nodes live in a single arena (a std::vector) and refer to each other by
+ * 32-bit indices instead of pointers. The color takes the highest bit of
+ * the left index, so a node is just the key and two 32-bit words: 12 bytes
+ * for an int key, instead of the 24 bytes (plus malloc overhead) of RBNode.
+ *
+ * Index 0 is a black sentinel that stands for the null child, so at most
+ * 2^31 - 1 keys fit in a tree. Insertion is the same bottom-up 2-3 LLRB
+ * insertion as RBNode::insert. */
+
+template<typename T>
+struct CompactRBNode {
+    static constexpr uint32_t RED_BIT = uint32_t{1} << 31;
+
+    T key;
+    uint32_t left_color;    /* Left child index | RED_BIT if red */
+    uint32_t right;
+};
+
+template<typename T>
+class CompactRBTree {
+public:
+    using Node = CompactRBNode<T>;
+    static constexpr uint32_t NIL = 0;
+
+    CompactRBTree() : nodes(1, Node{ T{}, 0, NIL }) {}
+
+    bool insert(const T&);
+    bool contains(const T&) const;
+
+    /* Pre-allocate room for n keys */
+    void reserve(size_t n) { nodes.reserve(n + 1); }
+
+    size_t size() const { return nodes.size() - 1; }
+
+    /* Bytes taken by the arena */
+    size_t memory_usage() const { return nodes.capacity() * sizeof(Node); }
+
+    template<typename F>
+    void traverse_inorder(F&& func) const;
+
+    /* Read-only access to the structure, by node index */
+    uint32_t get_root() const { return root; }
+    const T& key(uint32_t n) const { return nodes[n].key; }
+    uint32_t left(uint32_t n) const {
+        return nodes[n].left_color & ~Node::RED_BIT;
+    }
+    uint32_t right(uint32_t n) const { return nodes[n].right; }
+    bool is_red(uint32_t n) const { return nodes[n].left_color & Node::RED_BIT; }
+
+private:
+    std::vector<Node> nodes;
+    uint32_t root = NIL;
+
+    uint32_t child(uint32_t n, bool dir) const {
+        return dir ? right(n) : left(n);
+    }
+
+    void set_left(uint32_t n, uint32_t l) {
+        nodes[n].left_color = (nodes[n].left_color & Node::RED_BIT) | l;
+    }
+    void set_right(uint32_t n, uint32_t r) { nodes[n].right = r; }
+    void set_child(uint32_t n, bool dir, uint32_t c) {
+        if (dir)
+            set_right(n, c);
+        else
+            set_left(n, c);
+    }
+
+    void set_red(uint32_t n, bool red) {
+        nodes[n].left_color = left(n) | (red ? Node::RED_BIT : 0);
+    }
+
+    void flip_color(uint32_t n) {
+        nodes[n].left_color ^= Node::RED_BIT;
+        nodes[left(n)].left_color ^= Node::RED_BIT;
+        nodes[right(n)].left_color ^= Node::RED_BIT;
+    }
+
+    /* Unlike RBNode, the rotations and fix_up return the new root of the
+       subtree, and the caller relinks it to the parent. */
+    uint32_t rotate_left(uint32_t);
+    uint32_t rotate_right(uint32_t);
+    uint32_t fix_up(uint32_t);
+};
+
+template<typename T>
+uint32_t CompactRBTree<T>::rotate_left(uint32_t h) {
+    uint32_t x = right(h);
+    set_right(h, left(x));
+    set_left(x, h);
+    set_red(x, is_red(h));
+    set_red(h, true);
+    return x;
+}
+
+template<typename T>
+uint32_t CompactRBTree<T>::rotate_right(uint32_t h) {
+    uint32_t x = left(h);
+    set_left(h, right(x));
+    set_right(x, h);
+    set_red(x, is_red(h));
+    set_red(h, true);
+    return x;
+}
+
+template<typename T>
+uint32_t CompactRBTree<T>::fix_up(uint32_t h) {
+    if (is_red(right(h)) && !is_red(left(h)))
+        h = rotate_left(h);
+
+    if (is_red(left(h)) && is_red(left(left(h))))
+        h = rotate_right(h);
+
+    if (is_red(left(h)) && is_red(right(h)))
+        flip_color(h);
+
+    return h;
+}
+
+template<typename T>
+bool CompactRBTree<T>::insert(const T& t) {
+    uint32_t path[RB_MAX_DEPTH];
+    bool dirs[RB_MAX_DEPTH];
+    size_t depth = 0;
+
+    for (uint32_t n = root; n != NIL; ) {
+        const T& k = key(n);
+        if (t == k)
+            return false;
+
+        assert(depth < RB_MAX_DEPTH);
+        path[depth] = n;
+        dirs[depth] = !(t < k);
+        n = child(n, dirs[depth]);
+        depth++;
+    }
+
+    assert(nodes.size() < Node::RED_BIT);
+    uint32_t h = nodes.size();
+    nodes.push_back(Node{ t, NIL | Node::RED_BIT, NIL });
+
+    /* Hang the new node, then fix up and relink the ancestors until a
+       subtree root stays black */
+    for (;;) {
+        if (depth == 0) {
+            root = h;
+            break;
+        }
+
+        depth--;
+        set_child(path[depth], dirs[depth], h);
+        h = fix_up(path[depth]);
+        if (depth > 0 && !is_red(h)) {
+            set_child(path[depth - 1], dirs[depth - 1], h);
+            break;
+        }
+    }
+
+    set_red(root, false);
+    return true;
+}
+
+template<typename T>
+bool CompactRBTree<T>::contains(const T& t) const {
+    uint32_t n = root;
+
+    while (n != NIL) {
+        const T& k = nodes[n].key;
+        if (t == k)
+            return true;
+        n = t < k ? left(n) : nodes[n].right;
+    }
+
+    return false;
+}
+
+template<typename T>
+template<typename F>
+void CompactRBTree<T>::traverse_inorder(F&& func) const {
+    uint32_t stack[RB_MAX_DEPTH];
+    size_t depth = 0;
+    uint32_t n = root;
+
+    while (n != NIL || depth > 0) {
+        while (n != NIL) {
+            stack[depth++] = n;
+            n = left(n);
+        }
+
+        n = stack[--depth];
+        func(key(n));
+        n = right(n);
+    }
+}
+
+#endif // __COMPACT_RBTREE_H_
@@ -0,0 +1,523 @@
+#ifndef __CONCURRENT_RBTREE_H_
+#define __CONCURRENT_RBTREE_H_
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "rbtree.hpp"
+
+/* A left-leaning red-black tree for read-mostly workloads.
+ *
+ * Readers never lock and never write to shared memory but their own epoch
+ * slot. The tree is persistent: a writer never changes a node that readers
+ * may see. It copies the nodes it has to change (path copying), builds the
+ * new version of the tree under a mutex, and publishes it with a single
+ * atomic store of the root. A reader thus always sees one consistent
+ * version, whichever it loaded.
+ *
+ * The nodes a write replaced are reclaimed with epochs. A reader announces
+ * the global epoch in its slot while it runs; a replaced node is freed once
+ * every reader that could still hold it has left. */
+
+/**
+ * The epoch slots, shared by all trees. A thread claims a slot with a CAS on
+ * its first read and keeps it until it exits. Every slot has a cache line of
+ * its own, so readers on different cores never write to the same line.
+ *
+ * Reads nest, as a contains() in a for_all() callback or under a guard:
+ * only the outermost one announces an epoch and leaves it.
+ */
+class RBEpochDomain {
+public:
+    static constexpr size_t MAX_THREADS = 256;
+    static constexpr uint64_t QUIESCENT = 0;
+
+    struct alignas(64) Slot {
+        std::atomic<bool> claimed{false};
+        std::atomic<uint64_t> epoch{QUIESCENT};
+        /* Only touched by the thread that claimed the slot */
+        size_t depth = 0;
+    };
+
+    static RBEpochDomain& instance() {
+        static RBEpochDomain domain;
+        return domain;
+    }
+
+    Slot& my_slot();
+
+    void enter(Slot& slot) {
+        if (slot.depth++ == 0)
+            slot.epoch.store(global.load(std::memory_order_seq_cst),
+                             std::memory_order_seq_cst);
+    }
+
+    void exit(Slot& slot) {
+        if (--slot.depth == 0)
+            slot.epoch.store(QUIESCENT, std::memory_order_release);
+    }
+
+    uint64_t current() const { return global.load(std::memory_order_seq_cst); }
+    void advance() { global.fetch_add(1, std::memory_order_seq_cst); }
+
+    /* The oldest epoch a reader is still in, if any */
+    uint64_t min_active() const;
+
+private:
+    std::atomic<uint64_t> global{1};
+    Slot slots[MAX_THREADS];
+
+    RBEpochDomain() = default;
+};
+
+inline RBEpochDomain::Slot& RBEpochDomain::my_slot() {
+    struct Handle {
+        Slot* slot = nullptr;
+        ~Handle() {
+            if (slot)
+                slot->claimed.store(false, std::memory_order_release);
+        }
+    };
+    thread_local Handle handle;
+
+    if (handle.slot)
+        return *handle.slot;
+
+    for (auto& slot : slots) {
+        bool expected = false;
+        if (!slot.claimed.load(std::memory_order_relaxed) &&
+            slot.claimed.compare_exchange_strong(expected, true,
+                                                 std::memory_order_acquire)) {
+            handle.slot = &slot;
+            return slot;
+        }
+    }
+
+    throw std::runtime_error("RBEpochDomain: too many threads");
+}
+
+inline uint64_t RBEpochDomain::min_active() const {
+    uint64_t min = std::numeric_limits<uint64_t>::max();
+
+    for (const auto& slot : slots) {
+        uint64_t e = slot.epoch.load(std::memory_order_seq_cst);
+        if (e != QUIESCENT && e < min)
+            min = e;
+    }
+
+    return min;
+}
+
+/* Keeps the calling thread in the current epoch for its lifetime */
+class RBEpochGuard {
+public:
+    RBEpochGuard() : domain(RBEpochDomain::instance()), slot(domain.my_slot()) {
+        domain.enter(slot);
+    }
+    ~RBEpochGuard() { domain.exit(slot); }
+
+private:
+    RBEpochDomain& domain;
+    RBEpochDomain::Slot& slot;
+};
+
+template<typename T>
+struct ConcurrentRBNode {
+    T key;
+    color_t color;
+    ConcurrentRBNode* left;
+    ConcurrentRBNode* right;
+
+    /* The write that created the node. A writer changes its own nodes in
+       place, and copies all the others. */
+    uint64_t birth;
+};
+
+template<typename T>
+class ConcurrentRBTree {
+public:
+    using Node = ConcurrentRBNode<T>;
+
+    ConcurrentRBTree() = default;
+    ~ConcurrentRBTree();
+
+    /* Lock-free */
+    bool contains(const T&) const;
+
+    /* Serialized among writers; never block readers */
+    bool insert(const T&);
+    bool remove(const T&);
+
+    size_t size() const { return num_keys.load(std::memory_order_relaxed); }
+
+    /* In-order traversal of one consistent version of the tree */
+    template<typename F>
+    void for_all(F&& func) const;
+
+    /* For tests. Not safe while writers run. */
+    const Node* get_root() const { return root.load(); }
+
+private:
+    /* Free retired nodes once this many are pending */
+    static constexpr size_t RECLAIM_BATCH = 64;
+
+    std::atomic<Node*> root{nullptr};
+    std::atomic<size_t> num_keys{0};
+
+    /* Writer state, under the mutex */
+    std::mutex write_mutex;
+    uint64_t write_id = 0;
+    std::vector<Node*> replaced;                        /* By this write */
+    std::vector<std::pair<uint64_t, Node*>> retired;    /* (epoch, node) */
+
+    static bool is_red(const Node* n) { return n && n->color == RED; }
+
+    Node* make_node(const T& t) { return new Node{ t, RED, nullptr, nullptr, write_id }; }
+    Node* own(Node** link);
+    void drop(Node* n);
+
+    void flip_color(Node** link);
+    void rotate_left(Node** link);
+    void rotate_right(Node** link);
+    void fix_up(Node** link);
+    void move_red_left(Node** link);
+    void move_red_right(Node** link);
+    Node* detach_min(Node** link, Node*** path, size_t& depth);
+
+    void publish(Node* new_root);
+    void reclaim();
+
+    static void destroy(Node*);
+
+    ConcurrentRBTree(const ConcurrentRBTree&);
+    ConcurrentRBTree& operator=(const ConcurrentRBTree&);
+};
+
+/* Make the node at *link writable: copy it unless this write created it.
+   *link must itself be writable, i.e. the root or a link of an owned
+   node. */
+template<typename T>
+typename ConcurrentRBTree<T>::Node* ConcurrentRBTree<T>::own(Node** link) {
+    Node* n = *link;
+    if (n->birth == write_id)
+        return n;
+
+    Node* copy = new Node(*n);
+    copy->birth = write_id;
+    replaced.push_back(n);
+    *link = copy;
+    return copy;
+}
+
+/* Unlink a node for good */
+template<typename T>
+void ConcurrentRBTree<T>::drop(Node* n) {
+    if (n->birth == write_id)
+        delete n;
+    else
+        replaced.push_back(n);
+}
+
+template<typename T>
+void ConcurrentRBTree<T>::flip_color(Node** link) {
+    Node* h = own(link);
+    h->color = !h->color;
+
+    if (h->left) {
+        Node* l = own(&h->left);
+        l->color = !l->color;
+    }
+    if (h->right) {
+        Node* r = own(&h->right);
+        r->color = !r->color;
+    }
+}
+
+template<typename T>
+void ConcurrentRBTree<T>::rotate_left(Node** link) {
+    Node* h = own(link);
+    Node* x = own(&h->right);
+
+    h->right = x->left;
+    x->left = h;
+    x->color = h->color;
+    h->color = RED;
+    *link = x;
+}
+
+template<typename T>
+void ConcurrentRBTree<T>::rotate_right(Node** link) {
+    Node* h = own(link);
+    Node* x = own(&h->left);
+
+    h->left = x->right;
+    x->right = h;
+    x->color = h->color;
+    h->color = RED;
+    *link = x;
+}
+
+/* Same as RBNode::fix_up, without touching the nodes that need no change */
+template<typename T>
+void ConcurrentRBTree<T>::fix_up(Node** link) {
+    if (is_red((*link)->right) && !is_red((*link)->left))
+        rotate_left(link);
+
+    if (is_red((*link)->left) && is_red((*link)->left->left))
+        rotate_right(link);
+
+    if (is_red((*link)->left) && is_red((*link)->right))
+        flip_color(link);
+}
+
+template<typename T>
+void ConcurrentRBTree<T>::move_red_left(Node** link) {
+    flip_color(link);
+    if (is_red((*link)->right->left)) {
+        rotate_right(&own(link)->right);
+        rotate_left(link);
+        flip_color(link);
+    }
+}
+
+template<typename T>
+void ConcurrentRBTree<T>::move_red_right(Node** link) {
+    flip_color(link);
+    if (is_red((*link)->left->left)) {
+        rotate_right(link);
+        flip_color(link);
+    }
+}
+
+/* Bottom-up insertion, as RBNode::insert, on a private copy of the path */
+template<typename T>
+bool ConcurrentRBTree<T>::insert(const T& t) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_id++;
+
+    Node* new_root = root.load(std::memory_order_relaxed);
+    Node** path[RB_MAX_DEPTH];
+    size_t depth = 0;
+
+    /* Look first, so that a failed insertion copies nothing */
+    for (const Node* n = new_root; n; n = t < n->key ? n->left : n->right)
+        if (t == n->key)
+            return false;
+
+    Node** link = &new_root;
+    while (*link) {
+        Node* n = own(link);
+        assert(depth < RB_MAX_DEPTH);
+        path[depth++] = link;
+        link = t < n->key ? &n->left : &n->right;
+    }
+
+    *link = make_node(t);
+
+    while (depth > 0) {
+        link = path[--depth];
+        fix_up(link);
+        if (!is_red(*link))
+            break;
+    }
+
+    if (is_red(new_root))
+        own(&new_root)->color = BLK;
+
+    num_keys.fetch_add(1, std::memory_order_relaxed);
+    publish(new_root);
+    return true;
+}
+
+template<typename T>
+typename ConcurrentRBTree<T>::Node*
+ConcurrentRBTree<T>::detach_min(Node** link, Node*** path, size_t& depth) {
+    while ((*link)->left) {
+        if (!is_red((*link)->left) && !is_red((*link)->left->left))
+            move_red_left(link);
+
+        Node* h = own(link);
+        assert(depth < RB_MAX_DEPTH);
+        path[depth++] = link;
+        link = &h->left;
+    }
+
+    Node* min = *link;
+    *link = nullptr;
+    return min;
+}
+
+/* Top-down removal, as RBNode::remove */
+template<typename T>
+bool ConcurrentRBTree<T>::remove(const T& t) {
+    std::lock_guard<std::mutex> lock(write_mutex);
+    write_id++;
+
+    Node* new_root = root.load(std::memory_order_relaxed);
+
+    /* Unlike RBNode::remove, look first: the walk copies every node it
+       passes, which is wasted on an absent key. */
+    const Node* n = new_root;
+    while (n && !(t == n->key))
+        n = t < n->key ? n->left : n->right;
+    if (!n)
+        return false;
+
+    Node** path[RB_MAX_DEPTH];
+    size_t depth = 0;
+
+    if (!is_red(new_root->left) && !is_red(new_root->right))
+        own(&new_root)->color = RED;
+
+    Node** link = &new_root;
+    for (;;) {
+        if (t < (*link)->key) {
+            if (!is_red((*link)->left) && !is_red((*link)->left->left))
+                move_red_left(link);
+
+            Node* h = own(link);
+            assert(depth < RB_MAX_DEPTH);
+            path[depth++] = link;
+            link = &h->left;
+            continue;
+        }
+
+        if (is_red((*link)->left))
+            rotate_right(link);
+
+        if (t == (*link)->key && !(*link)->right) {
+            drop(*link);
+            *link = nullptr;
+            break;
+        }
+
+        if (!is_red((*link)->right) && !is_red((*link)->right->left))
+            move_red_right(link);
+
+        Node* h = own(link);
+        assert(depth < RB_MAX_DEPTH);
+        path[depth++] = link;
+
+        if (t == h->key) {
+            Node* min = detach_min(&h->right, path, depth);
+            /* Unless this write created min, readers may still reach it in
+               the published version */
+            if (min->birth == write_id)
+                h->key = std::move(min->key);
+            else
+                h->key = min->key;
+            drop(min);
+            break;
+        }
+
+        link = &h->right;
+    }
+
+    while (depth > 0)
+        fix_up(path[--depth]);
+
+    if (is_red(new_root))
+        own(&new_root)->color = BLK;
+
+    num_keys.fetch_sub(1, std::memory_order_relaxed);
+    publish(new_root);
+    return true;
+}
+
+/* Make the new version visible, and retire the nodes it replaced. The
+   store is sequentially consistent with the readers' epoch announcements,
+   see reclaim(). */
+template<typename T>
+void ConcurrentRBTree<T>::publish(Node* new_root) {
+    root.store(new_root, std::memory_order_seq_cst);
+
+    auto& domain = RBEpochDomain::instance();
+    uint64_t epoch = domain.current();
+    for (auto n : replaced)
+        retired.emplace_back(epoch, n);
+    replaced.clear();
+    domain.advance();
+
+    if (retired.size() >= RECLAIM_BATCH)
+        reclaim();
+}
+
+/**
+ * A node retired in epoch e was unlinked before the global epoch moved past
+ * e. A reader in a later epoch loaded the root after that, so it can only
+ * reach the new version. A reader that announced its epoch but had not yet
+ * stored it when min_active() looked loads the root after the new one was
+ * published, for the same reason.
+ */
+template<typename T>
+void ConcurrentRBTree<T>::reclaim() {
+    uint64_t min = RBEpochDomain::instance().min_active();
+
+    size_t kept = 0;
+    for (auto& [epoch, n] : retired) {
+        if (epoch < min)
+            delete n;
+        else
+            retired[kept++] = { epoch, n };
+    }
+    retired.resize(kept);
+}
+
+template<typename T>
+bool ConcurrentRBTree<T>::contains(const T& t) const {
+    RBEpochGuard guard;
+
+    for (const Node* n = root.load(std::memory_order_seq_cst); n; ) {
+        if (t == n->key)
+            return true;
+        n = t < n->key ? n->left : n->right;
+    }
+
+    return false;
+}
+
+template<typename T>
+template<typename F>
+void ConcurrentRBTree<T>::for_all(F&& func) const {
+    RBEpochGuard guard;
+    const Node* stack[RB_MAX_DEPTH];
+    size_t depth = 0;
+    const Node* n = root.load(std::memory_order_seq_cst);
+
+    while (n || depth > 0) {
+        for (; n; n = n->left)
+            stack[depth++] = n;
+
+        n = stack[--depth];
+        func(n->key);
+        n = n->right;
+    }
+}
+
+template<typename T>
+void ConcurrentRBTree<T>::destroy(Node* n) {
+    if (!n)
+        return;
+
+    destroy(n->left);
+    destroy(n->right);
+    delete n;
+}
+
+/* No reader may run concurrently with the destructor */
+template<typename T>
+ConcurrentRBTree<T>::~ConcurrentRBTree() {
+    destroy(root.load());
+
+    for (auto& [epoch, n] : retired)
+        delete n;
+}
+
+#endif // __CONCURRENT_RBTREE_H_
@@ -0,0 +1,131 @@
+#ifndef __RBMAP_H_
+#define __RBMAP_H_
+
+#include <stdexcept>
+#include <utility>
+
+#include "rbtree.hpp"
+
+/* An ordered map on top of RBTree.
+ *
+ * The tree stores RBMapEntry objects, which compare by key only, so the
+ * whole LLRB machinery (insertion, removal, iterators, bounds) is shared
+ * with the set. Entries also compare with a bare K, so lookups never build
+ * a dummy entry. */
+
+template<typename K, typename V>
+struct RBMapEntry {
+    K key;
+
+    /* The tree only hands out const entries, as changing the key would
+       break the order. The value does not take part in it, and can be
+       updated through the map's iterators. */
+    mutable V value;
+
+    friend bool operator<(const RBMapEntry& a, const RBMapEntry& b) {
+        return a.key < b.key;
+    }
+    friend bool operator==(const RBMapEntry& a, const RBMapEntry& b) {
+        return a.key == b.key;
+    }
+
+    friend bool operator<(const RBMapEntry& a, const K& k) { return a.key < k; }
+    friend bool operator<(const K& k, const RBMapEntry& a) { return k < a.key; }
+    friend bool operator==(const RBMapEntry& a, const K& k) { return a.key == k; }
+    friend bool operator==(const K& k, const RBMapEntry& a) { return k == a.key; }
+};
+
+template<typename K, typename V>
+class RBMap {
+public:
+    using Entry = RBMapEntry<K, V>;
+    using iterator = RBTreeIterator<Entry>;
+
+    iterator begin() const { return tree.begin(); }
+    iterator end() const { return tree.end(); }
+
+    iterator find(const K& k) const { return tree.find(k); }
+    iterator lower_bound(const K& k) const { return tree.lower_bound(k); }
+    iterator upper_bound(const K& k) const { return tree.upper_bound(k); }
+    bool contains(const K& k) const { return tree.contains(k); }
+
+    /* Throw std::out_of_range if k is absent */
+    V& at(const K& k);
+    const V& at(const K& k) const;
+
+    /* Inserts a default-constructed value if k is absent */
+    V& operator[](const K& k);
+
+    /* Returns false, leaving the map unchanged, if k is already there */
+    bool insert(const K& k, const V& v);
+
+    /* Returns true if k was inserted, false if its value was replaced */
+    bool insert_or_assign(const K& k, const V& v);
+
+    bool erase(const K& k);
+
+    size_t size() const { return num_entries; }
+    bool empty() const { return num_entries == 0; }
+
+private:
+    /* The tree hands out const entries, but they are this map's own */
+    static Entry& own(const iterator& it) { return const_cast<Entry&>(*it); }
+
+    RBTree<Entry> tree;
+    size_t num_entries = 0;
+};
+
+template<typename K, typename V>
+V& RBMap<K, V>::at(const K& k) {
+    return const_cast<V&>(std::as_const(*this).at(k));
+}
+
+template<typename K, typename V>
+const V& RBMap<K, V>::at(const K& k) const {
+    auto it = find(k);
+    if (it == end())
+        throw std::out_of_range("RBMap::at");
+
+    return it->value;
+}
+
+template<typename K, typename V>
+V& RBMap<K, V>::operator[](const K& k) {
+    auto it = find(k);
+    if (it != end())
+        return own(it).value;
+
+    insert(k, V{});
+    return own(find(k)).value;
+}
+
+template<typename K, typename V>
+bool RBMap<K, V>::insert(const K& k, const V& v) {
+    if (!tree.insert(Entry{ k, v }))
+        return false;
+
+    num_entries++;
+    return true;
+}
+
+template<typename K, typename V>
+bool RBMap<K, V>::insert_or_assign(const K& k, const V& v) {
+    auto it = find(k);
+    if (it != end()) {
+        own(it).value = v;
+        return false;
+    }
+
+    return insert(k, v);
+}
+
+template<typename K, typename V>
+bool RBMap<K, V>::erase(const K& k) {
+    if (!tree.remove(k))
+        return false;
+
+    num_entries--;
+    return true;
+}
+
+#endif // __RBMAP_H_
@@ -15,13 +15,18 @@
 #include <iostream>
 #include <optional>
 #include <fstream>
+#include <iterator>
+#include <cstddef>
+#include <cstdint>
 #include <stdio.h>
-
-static size_t null_count = 0;
+#include <limits>
 
 template <typename T>
 struct RBNode;
 
+template <typename T>
+struct RBTreeIterator;
+
 using color_t = bool;
 constexpr static color_t RED = false;
 constexpr static color_t BLK = true;
@@ -29,27 +34,96 @@ constexpr static color_t BLK = true;
 /* This is an abstraction for search-path. For debugging purpose */
 struct Path;
 
+static constexpr size_t RB_NO_DEPTH_LIMIT = std::numeric_limits<size_t>::max();
+
+/* Entries per line printed by operator<< */
+static constexpr size_t RB_LEVEL_WIDTH = 64;
+
+/* Whether RBTree<T> lookups take a K. An integer K of the other
+   signedness than an integer T would be compared after a conversion,
+   which finds the wrong keys for negative values. */
+template<typename T, typename K>
+constexpr bool rb_lookup_key_v =
+    !(std::is_integral_v<T> && std::is_integral_v<K> &&
+      std::is_signed_v<T> != std::is_signed_v<K>);
+
+/* The result of RBTree::validate() */
+struct RBTreeStats {
+    bool valid = true;
+    const char* error = nullptr;    /* The first violation found */
+
+    size_t size = 0;
+    size_t black_height = 0;        /* Black nodes from the root to a null */
+    size_t max_depth = 0;           /* Nodes on the longest path */
+    size_t num_red = 0;
+
+    double red_ratio() const { return size ? double(num_red) / size : 0; }
+};
+
 template<typename T>
 struct RBTree {
     std::unique_ptr<RBNode<T>> root = nullptr;
 
+    RBTree() = default;
+    RBTree(RBTree&&) = default;
+    RBTree& operator=(RBTree&&) = default;
     ~RBTree() = default;
 
     bool insert(const T&);
     void remove_max();
     void remove_min();
-    void remove(const T&);
+
+    /* Lookups and removal also accept any K that compares with T through
+       `<` and `==`, such as the key alone of an RBMap entry */
+    template<typename K = T>
+    bool remove(const K&);
 
     const std::optional<T> leftmost_key();
     const std::optional<T> rightmost_key();
 
     void traverse_inorder(std::function<void(RBNode<T>*)>);
 
-    bool contains(const T& t);
+    template<typename K = T>
+    bool contains(const K& t) const;
+
+    using iterator = RBTreeIterator<T>;
+
+    iterator begin() const;
+    iterator end() const;
+
+    template<typename K = T>
+    iterator find(const K&) const;
+    /* The first key that is not less than t */
+    template<typename K = T>
+    iterator lower_bound(const K&) const;
+    /* The first key that is greater than t */
+    template<typename K = T>
+    iterator upper_bound(const K&) const;
+
+    /* Finger search: start from hint instead of the root, in amortized
+       O(1) when t is next to *hint, as with sorted input. hint must come
+       from this tree, with no change to the tree since but the insert
+       that returned it. Returns t, whether it was inserted or not. */
+    iterator insert(iterator hint, const T&);
+    template<typename K = T>
+    iterator find(iterator hint, const K&) const;
 
     std::unordered_map<Path, const RBNode<T>&> collect_all_leaves() const;
 
-    std::string format_graphviz();
+    template<typename K>
+    static size_t climb(const iterator&, const K&);
+    template<typename K>
+    bool descend(iterator&, const K&) const;
+
+    /* Check every invariant of the tree in one pass, without allocating */
+    RBTreeStats validate() const;
+
+    /* Stream the tree to os in one pass. Subtrees below max_depth levels
+       are cut and marked as such. Keys are written with operator<<. */
+    void write_graphviz(std::ostream&, size_t max_depth = RB_NO_DEPTH_LIMIT) const;
+    void write_json(std::ostream&, size_t max_depth = RB_NO_DEPTH_LIMIT) const;
+
+    std::string format_graphviz() const;
 };
 
 template<typename T>
@@ -65,37 +139,40 @@ struct RBNode {
     bool is_leaf();
 
     void flip_color();
-    static RBNode* rotate_right(std::unique_ptr<RBNode>&);
-    static RBNode* rotate_left(std::unique_ptr<RBNode>&);
+    static void rotate_right(std::unique_ptr<RBNode>&);
+    static void rotate_left(std::unique_ptr<RBNode>&);
     static bool is_red(const std::unique_ptr<RBNode>&);
 
-    static RBNode* move_red_right(std::unique_ptr<RBNode>&);
-    static RBNode* move_red_left(std::unique_ptr<RBNode>&);
+    static void move_red_right(std::unique_ptr<RBNode>&);
+    static void move_red_left(std::unique_ptr<RBNode>&);
 
-    static RBNode* remove_max(std::unique_ptr<RBNode>&);
-    static RBNode* remove_min(std::unique_ptr<RBNode>&);
-    static RBNode* remove(std::unique_ptr<RBNode>&, const T&);
+    /* These take the link to the root of a subtree, and work in a single
+       iterative pass down and back up along an explicit path stack. */
+    static void remove_max(std::unique_ptr<RBNode>&);
+    static void remove_min(std::unique_ptr<RBNode>&);
+    template<typename K>
+    static bool remove(std::unique_ptr<RBNode>&, const K&);
 
-    static RBNode* insert(std::unique_ptr<RBNode>&, const T&);
+    static bool insert(std::unique_ptr<RBNode>&, const T&);
     std::pair<RBNode<T>*, Path> search(const T&, Path);
 
     void traverse_inorder(std::function<void(RBNode*)>);
     size_t get_max_depth();
 
-    std::unordered_map<size_t, const RBNode&> get_nodes_at_level(size_t);
-    void _get_nodes_at_level(size_t,
-                             std::unordered_map<size_t, const RBNode&>&,
-                             Path);
-    std::string format_level(size_t);
+    /* One line per level, at most max_width entries each */
+    void write_levels(std::ostream&, size_t max_width) const;
 
     std::unordered_map<Path, const RBNode<T>&> collect_all_leaves(void);
     void _collect_all_leaves(std::unordered_map<Path, const RBNode<T>&>&, Path);
 
-    static RBNode* fix_up(std::unique_ptr<RBNode>&);
+    static void fix_up(std::unique_ptr<RBNode>&);
 
-    std::string format_graphviz();
+    /* null_id numbers the null links and cut subtrees of one dump */
+    void write_graphviz(std::ostream&, size_t& null_id, size_t max_depth) const;
+    void write_json(std::ostream&, size_t max_depth) const;
 
-    bool contains(const T& t);
+    template<typename K>
+    bool contains(const K& t) const;
 
     const T& leftmost_key();
     const T& rightmost_key();
@@ -103,24 +180,25 @@ struct RBNode {
 
 template<typename T>
 bool RBTree<T>::insert(const T& t) {
-    if (!root) {
-        root = std::make_unique<RBNode<T>>(t);
-        root->color = BLK;
-        return true;
-    }
-
-    root.reset(RBNode<T>::insert(root, t));
+    bool inserted = RBNode<T>::insert(root, t);
 
     /* Change root to black. Won't affect the balance */
-    if (root->color == RED)
-        root->color = BLK;
+    root->color = BLK;
 
-    return true;
+    return inserted;
 }
 
+/* The removals below expect the root to be red when both of its children
+   are black, so that there is a red node to push down the search path. */
 template<typename T>
 void RBTree<T>::remove_max() {
-    root.reset(RBNode<T>::remove_max(root));
+    if (!root)
+        return;
+
+    if (!RBNode<T>::is_red(root->left) && !RBNode<T>::is_red(root->right))
+        root->color = RED;
+
+    RBNode<T>::remove_max(root);
 
     if (root)
         root->color = BLK;
@@ -128,18 +206,34 @@ void RBTree<T>::remove_max() {
 
 template<typename T>
 void RBTree<T>::remove_min() {
-    root.reset(RBNode<T>::remove_min(root));
+    if (!root)
+        return;
+
+    if (!RBNode<T>::is_red(root->left) && !RBNode<T>::is_red(root->right))
+        root->color = RED;
+
+    RBNode<T>::remove_min(root);
 
     if (root)
         root->color = BLK;
 }
 
 template<typename T>
-void RBTree<T>::remove(const T& t) {
-    root.reset(RBNode<T>::remove(root, t));
+template<typename K>
+bool RBTree<T>::remove(const K& t) {
+    static_assert(rb_lookup_key_v<T, K>, "key signedness differs from T's");
+    if (!root)
+        return false;
+
+    if (!RBNode<T>::is_red(root->left) && !RBNode<T>::is_red(root->right))
+        root->color = RED;
+
+    bool removed = RBNode<T>::remove(root, t);
 
     if (root)
         root->color = BLK;
+
+    return removed;
 }
 
 template <typename T>
@@ -159,7 +253,9 @@ const std::optional<T> RBTree<T>::rightmost_key() {
 }
 
 template <typename T>
-bool RBTree<T>::contains(const T& t) {
+template <typename K>
+bool RBTree<T>::contains(const K& t) const {
+    static_assert(rb_lookup_key_v<T, K>, "key signedness differs from T's");
     if (!root)
         return false;
 
@@ -224,50 +320,82 @@ void RBNode<T>::flip_color() {
         right->color = !right->color;
 }
 
+/* A path from the root is never longer than 2 lg(n + 1), plus the
+   temporary red links a removal pushes down. */
+static constexpr size_t RB_MAX_DEPTH = 2 * 64 + 2;
+
+/* Rotations relink the subtree in place: the link keeps pointing to the
+   root of the subtree, which is now the former child. */
 template<typename T>
-RBNode<T>* RBNode<T>::rotate_right(std::unique_ptr<RBNode<T>>& y) {
-	assert(y->left);
-	RBNode<T>* x = y->left.release();
-	std::swap(x->color, y->color);
-	y->left = std::move(x->right);		
-	x->right = std::move(y);
-	return x;
+void RBNode<T>::rotate_right(std::unique_ptr<RBNode<T>>& h) {
+	assert(h->left);
+	std::unique_ptr<RBNode<T>> x = std::move(h->left);
+	h->left = std::move(x->right);
+	x->color = h->color;
+	h->color = RED;
+	x->right = std::move(h);
+	h = std::move(x);
 }
 
 template<typename T>
-RBNode<T>* RBNode<T>::rotate_left(std::unique_ptr<RBNode<T>>& x) {
-	assert(x->right);
-	RBNode<T>* y = x->right.release();
-	std::swap(x->color, y->color);
-	x->right = std::move(y->left);		
-	y->left = std::move(x);
-	return y;
+void RBNode<T>::rotate_left(std::unique_ptr<RBNode<T>>& h) {
+	assert(h->right);
+	std::unique_ptr<RBNode<T>> x = std::move(h->right);
+	h->right = std::move(x->left);
+	x->color = h->color;
+	h->color = RED;
+	x->left = std::move(h);
+	h = std::move(x);
+}
+
+/* Restore the invariants of the 2-3 LLRB tree at h, assuming they hold
+   below it */
+template<typename T>
+void RBNode<T>::fix_up(std::unique_ptr<RBNode<T>>& h) {
+	if(is_red(h->right) && !is_red(h->left))
+		rotate_left(h);
+
+	if(is_red(h->left) && is_red(h->left->left))
+		rotate_right(h);
+
+	if(is_red(h->left) && is_red(h->right))
+		h->flip_color();
 }
 
+/**
+ * Bottom-up insertion. Walk down to the empty link where t belongs, hang a
+ * red node there, and fix up the ancestors on the way back. The only change
+ * a fix-up makes visible to the parent is the color of the subtree root, so
+ * the walk stops at the first subtree whose root is black.
+ *
+ * @return false if t is already in the tree
+ */
 template<typename T>
-RBNode<T>* RBNode<T>::insert(std::unique_ptr<RBNode<T>>& n, const T& t) {
-	if(!n) {
-		n.reset(new RBNode<T>(t));
-		return n.release();
+bool RBNode<T>::insert(std::unique_ptr<RBNode<T>>& root, const T& t) {
+	std::unique_ptr<RBNode<T>>* path[RB_MAX_DEPTH];
+	size_t depth = 0;
+
+	std::unique_ptr<RBNode<T>>* link = &root;
+	while(*link) {
+		RBNode<T>* n = link->get();
+		if(t == n->key)
+			return false;
+
+		assert(depth < RB_MAX_DEPTH);
+		path[depth++] = link;
+		link = t < n->key ? &n->left : &n->right;
 	}
 
-	if(RBNode<T>::is_red(n->left) && RBNode<T>::is_red(n->right))
-		n->flip_color();
-	
-	if(t == n->key)
-		return n.release();
-	else if(t < n->key)
-		n->left.reset(RBNode<T>::insert(n->left, t));
-	else
-		n->right.reset(RBNode<T>::insert(n->right, t));
+	*link = std::make_unique<RBNode<T>>(t);
 
-	if(RBNode<T>::is_red(n->right))
-		n.reset(rotate_left(n));
-	
-	if(RBNode<T>::is_red(n->left) && RBNode<T>::is_red(n->left->left))
-		n.reset(rotate_right(n));
+	while(depth > 0) {
+		link = path[--depth];
+		fix_up(*link);
+		if(!is_red(*link))
+			break;
+	}
 
-	return n.release();
+	return true;
 }
 
 template<typename T>
@@ -285,40 +413,160 @@ std::pair<RBNode<T>*, Path> RBNode<T>::search(const T& t, Path sp) {
     }
 }
 
+/* Make h.left or one of its children red, borrowing from the right
+   sibling when it can spare a node. Assumes h is red and both h.left and
+   h.left.left are black. */
 template<typename T>
-RBNode<T>* RBNode<T>::fix_up(std::unique_ptr<RBNode<T>>& n) {
-    // TODO
-    return nullptr;
+void RBNode<T>::move_red_left(std::unique_ptr<RBNode<T>>& h) {
+	h->flip_color();
+	if(is_red(h->right->left)) {
+		rotate_right(h->right);
+		rotate_left(h);
+		h->flip_color();
+	}
 }
 
+/* The mirror image of move_red_left, for h.right */
 template<typename T>
-RBNode<T>* RBNode<T>::move_red_right(std::unique_ptr<RBNode<T>>& n) {
-    // TODO
-    return nullptr;
+void RBNode<T>::move_red_right(std::unique_ptr<RBNode<T>>& h) {
+	h->flip_color();
+	if(is_red(h->left->left)) {
+		rotate_right(h);
+		h->flip_color();
+	}
+}
+
+/* Unlink the minimum of the subtree at `link`, pushing the visited links
+   onto the path. The node at `link` must be red or have a red left child. */
+template<typename T>
+static std::unique_ptr<RBNode<T>>
+detach_min(std::unique_ptr<RBNode<T>>* link,
+           std::unique_ptr<RBNode<T>>** path, size_t& depth) {
+	while((*link)->left) {
+		if(!RBNode<T>::is_red((*link)->left) &&
+		   !RBNode<T>::is_red((*link)->left->left))
+			RBNode<T>::move_red_left(*link);
+
+		assert(depth < RB_MAX_DEPTH);
+		path[depth++] = link;
+		link = &(*link)->left;
+	}
+
+	/* In a left-leaning tree, a node with no left child has no right
+	   child either */
+	return std::move(*link);
 }
 
 template<typename T>
-RBNode<T>* RBNode<T>::remove_max(std::unique_ptr<RBNode<T>>& n) {
-    // TODO
-    return nullptr;
+static void fix_up_path(std::unique_ptr<RBNode<T>>** path, size_t depth) {
+	while(depth > 0)
+		RBNode<T>::fix_up(*path[--depth]);
 }
 
 template<typename T>
-RBNode<T>* RBNode<T>::move_red_left(std::unique_ptr<RBNode<T>>& n) {
-    // TODO
-    return nullptr;
+void RBNode<T>::remove_max(std::unique_ptr<RBNode<T>>& root) {
+	std::unique_ptr<RBNode<T>>* path[RB_MAX_DEPTH];
+	size_t depth = 0;
+
+	std::unique_ptr<RBNode<T>>* link = &root;
+	for(;;) {
+		if(is_red((*link)->left))
+			rotate_right(*link);
+
+		if(!(*link)->right) {
+			link->reset();
+			break;
+		}
+
+		if(!is_red((*link)->right) && !is_red((*link)->right->left))
+			move_red_right(*link);
+
+		assert(depth < RB_MAX_DEPTH);
+		path[depth++] = link;
+		link = &(*link)->right;
+	}
+
+	fix_up_path(path, depth);
 }
 
 template<typename T>
-RBNode<T>* RBNode<T>::remove_min(std::unique_ptr<RBNode<T>>& n) {
-    // TODO
-    return nullptr;
+void RBNode<T>::remove_min(std::unique_ptr<RBNode<T>>& root) {
+	std::unique_ptr<RBNode<T>>* path[RB_MAX_DEPTH];
+	size_t depth = 0;
+
+	detach_min(&root, path, depth);
+	fix_up_path(path, depth);
 }
 
+/**
+ * Top-down removal of t. On the way down, keep the current node or its
+ * child on the search path red, so that the node finally unlinked is never
+ * a lone black node. An internal node takes the key of its successor, which
+ * is unlinked instead.
+ *
+ * If t is absent, the walk ends at an empty link. The transformations on
+ * the way down keep the black balance, and the fix-ups on the way back undo
+ * the red links they left, so no separate lookup is needed beforehand.
+ *
+ * @return false if t is not in the tree
+ */
 template<typename T>
-RBNode<T>* RBNode<T>::remove(std::unique_ptr<RBNode<T>>& n, const T& t) {
-    // TODO
-    return nullptr;
+template<typename K>
+bool RBNode<T>::remove(std::unique_ptr<RBNode<T>>& root, const K& t) {
+	std::unique_ptr<RBNode<T>>* path[RB_MAX_DEPTH];
+	size_t depth = 0;
+
+	std::unique_ptr<RBNode<T>>* link = &root;
+	bool found = true;
+	for(;;) {
+		RBNode<T>* h = link->get();
+
+		if(t < h->key) {
+			if(!h->left) {
+				found = false;
+				path[depth++] = link;
+				break;
+			}
+
+			if(!is_red(h->left) && !is_red(h->left->left))
+				move_red_left(*link);
+
+			assert(depth < RB_MAX_DEPTH);
+			path[depth++] = link;
+			link = &(*link)->left;
+			continue;
+		}
+
+		if(is_red(h->left))
+			rotate_right(*link);
+
+		h = link->get();
+		if(!h->right) {
+			found = t == h->key;
+			if(found)
+				link->reset();
+			else
+				path[depth++] = link;
+			break;
+		}
+
+		if(!is_red(h->right) && !is_red(h->right->left))
+			move_red_right(*link);
+
+		h = link->get();
+		assert(depth < RB_MAX_DEPTH);
+		path[depth++] = link;
+
+		if(t == h->key) {
+			h->key = std::move(detach_min(&h->right, path, depth)->key);
+			break;
+		}
+
+		link = &h->right;
+	}
+
+	fix_up_path(path, depth);
+	return found;
 }
 
 template<typename T>
@@ -338,7 +586,8 @@ const T& RBNode<T>::rightmost_key() {
 }
 
 template<typename T>
-bool RBNode<T>::contains(const T& t) {
+template<typename K>
+bool RBNode<T>::contains(const K& t) const {
     if (t == key)
         return true;
     if (t < key)
@@ -347,6 +596,419 @@ bool RBNode<T>::contains(const T& t) {
         return right && right->contains(t);
 }
 
+/**
+ * Bidirectional in-order iterator. Nodes have no parent pointers, so the
+ * iterator keeps the path from the root to the current node, whose last
+ * entry is the current node. An empty path is the end; it still knows the
+ * tree, so that the end can be decremented.
+ *
+ * runs[i] is the first index of the run of links on the same side that
+ * ends at path[i]: path[runs[i]] to path[i] are all left children, or all
+ * right children, of the previous node. path[0] is a run of its own. It
+ * lets RBTree::climb() skip the ancestors that cannot bound a key in one
+ * step.
+ *
+ * Any insertion or removal invalidates all iterators.
+ */
+template<typename T>
+struct RBTreeIterator {
+    using iterator_category = std::bidirectional_iterator_tag;
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const T*;
+    using reference = const T&;
+
+    /* Paths of trees with up to 2^32 keys fit without growing */
+    static constexpr size_t PATH_RESERVE = 64;
+
+    const RBNode<T>* root = nullptr;
+    std::vector<const RBNode<T>*> path;
+    std::vector<uint32_t> runs;
+
+    RBTreeIterator() = default;
+    explicit RBTreeIterator(const RBNode<T>* r) : root(r) {}
+
+    reference operator*() const { return path.back()->key; }
+    pointer operator->() const { return &path.back()->key; }
+
+    RBTreeIterator& operator++();
+    RBTreeIterator operator++(int) { auto it = *this; ++*this; return it; }
+    RBTreeIterator& operator--();
+    RBTreeIterator operator--(int) { auto it = *this; --*this; return it; }
+
+    bool operator==(const RBTreeIterator& other) const {
+        if (path.empty() || other.path.empty())
+            return path.empty() == other.path.empty();
+        return path.back() == other.path.back();
+    }
+    bool operator!=(const RBTreeIterator& other) const { return !(*this == other); }
+
+    void push_leftmost(const RBNode<T>*);
+    void push_rightmost(const RBNode<T>*);
+
+    /* Change the path, keeping runs in step */
+    void push(const RBNode<T>*);
+    void pop() { path.pop_back(); runs.pop_back(); }
+    void cut(size_t len) { path.resize(len); runs.resize(len); }
+    void reserve() { path.reserve(PATH_RESERVE); runs.reserve(PATH_RESERVE); }
+};
+
+template<typename T>
+void RBTreeIterator<T>::push(const RBNode<T>* n) {
+    size_t i = path.size();
+    uint32_t run = i;
+
+    if (i >= 2 && (path[i - 1]->left.get() == n) ==
+                  (path[i - 2]->left.get() == path[i - 1]))
+        run = runs[i - 1];
+
+    path.push_back(n);
+    runs.push_back(run);
+}
+
+template<typename T>
+void RBTreeIterator<T>::push_leftmost(const RBNode<T>* n) {
+    for (; n; n = n->left.get())
+        push(n);
+}
+
+template<typename T>
+void RBTreeIterator<T>::push_rightmost(const RBNode<T>* n) {
+    for (; n; n = n->right.get())
+        push(n);
+}
+
+template<typename T>
+RBTreeIterator<T>& RBTreeIterator<T>::operator++() {
+    const RBNode<T>* n = path.back();
+
+    if (n->right) {
+        push_leftmost(n->right.get());
+        return *this;
+    }
+
+    /* Climb until we come up from a left child */
+    pop();
+    while (!path.empty() && path.back()->right.get() == n) {
+        n = path.back();
+        pop();
+    }
+
+    return *this;
+}
+
+template<typename T>
+RBTreeIterator<T>& RBTreeIterator<T>::operator--() {
+    if (path.empty()) {
+        push_rightmost(root);
+        return *this;
+    }
+
+    const RBNode<T>* n = path.back();
+
+    if (n->left) {
+        push_rightmost(n->left.get());
+        return *this;
+    }
+
+    pop();
+    while (!path.empty() && path.back()->left.get() == n) {
+        n = path.back();
+        pop();
+    }
+
+    return *this;
+}
+
+template<typename T>
+RBTreeIterator<T> RBTree<T>::begin() const {
+    iterator it{root.get()};
+    it.reserve();
+    it.push_leftmost(root.get());
+    return it;
+}
+
+template<typename T>
+RBTreeIterator<T> RBTree<T>::end() const {
+    return iterator{root.get()};
+}
+
+/* Walk down to t, and cut the path back to the last node where the walk
+   turned left, which is the first key greater than t (or equal to it, for
+   lower_bound). */
+template<typename T>
+template<typename K>
+RBTreeIterator<T> RBTree<T>::lower_bound(const K& t) const {
+    static_assert(rb_lookup_key_v<T, K>, "key signedness differs from T's");
+    iterator it{root.get()};
+    it.reserve();
+    size_t len = 0;
+
+    for (const RBNode<T>* n = root.get(); n; ) {
+        it.push(n);
+        if (n->key < t) {
+            n = n->right.get();
+        } else {
+            len = it.path.size();
+            if (t == n->key)
+                break;
+            n = n->left.get();
+        }
+    }
+
+    it.cut(len);
+    return it;
+}
+
+template<typename T>
+template<typename K>
+RBTreeIterator<T> RBTree<T>::upper_bound(const K& t) const {
+    static_assert(rb_lookup_key_v<T, K>, "key signedness differs from T's");
+    iterator it{root.get()};
+    it.reserve();
+    size_t len = 0;
+
+    for (const RBNode<T>* n = root.get(); n; ) {
+        it.push(n);
+        if (t < n->key) {
+            len = it.path.size();
+            n = n->left.get();
+        } else {
+            n = n->right.get();
+        }
+    }
+
+    it.cut(len);
+    return it;
+}
+
+template<typename T>
+template<typename K>
+RBTreeIterator<T> RBTree<T>::find(const K& t) const {
+    iterator it = lower_bound(t);
+
+    if (it.path.empty() || !(t == *it))
+        return end();
+
+    return it;
+}
+
+/**
+ * The lowest node of path whose subtree can hold t, as an index into path.
+ *
+ * The keys of a subtree lie between those of the closest ancestors that
+ * have it on their left and on their right. Going right from the last node,
+ * climb through the ancestors having the path on their left (going left,
+ * on their right) until one of them is past t. The others come in runs,
+ * each passed in one step, so that climbing from the last node of a spine
+ * does not walk the whole spine.
+ */
+template<typename T>
+template<typename K>
+size_t RBTree<T>::climb(const iterator& it, const K& t) {
+    const auto& path = it.path;
+    size_t k = path.size() - 1;
+    if (t == path[k]->key)
+        return k;
+
+    bool right = path[k]->key < t;
+
+    for (size_t j = k; j > 0; ) {
+        const RBNode<T>* p = path[j - 1];
+
+        /* No parent up this run bounds t on that side: skip to its top */
+        if ((p->left.get() == path[j]) != right) {
+            j = it.runs[j] - 1;
+            continue;
+        }
+
+        if (right ? t < p->key : p->key < t)
+            break;
+        k = --j;
+    }
+
+    return k;
+}
+
+/* Walk down from the last node of path (or the root, if there is none) to
+   t or to the null link where it belongs, pushing the nodes on the way.
+   Returns whether t was found, at path.back(). */
+template<typename T>
+template<typename K>
+bool RBTree<T>::descend(iterator& it, const K& t) const {
+    static_assert(rb_lookup_key_v<T, K>, "key signedness differs from T's");
+    const RBNode<T>* n = it.path.empty() ? root.get() : it.path.back();
+
+    if (!it.path.empty()) {
+        if (t == n->key)
+            return true;
+        n = t < n->key ? n->left.get() : n->right.get();
+    }
+
+    for (; n; n = t < n->key ? n->left.get() : n->right.get()) {
+        it.push(n);
+        if (t == n->key)
+            return true;
+    }
+
+    return false;
+}
+
+template<typename T>
+template<typename K>
+RBTreeIterator<T> RBTree<T>::find(iterator hint, const K& t) const {
+    hint.reserve();
+    if (!hint.path.empty())
+        hint.cut(climb(hint, t) + 1);
+
+    if (!descend(hint, t))
+        return end();
+
+    return hint;
+}
+
+/**
+ * The same bottom-up insertion as RBNode::insert, starting from the node
+ * climb() finds. The links to fix up are found through the parents on the
+ * path, and only for the levels that the fix-up reaches.
+ *
+ * Nothing above the level where the fix-up stops is changed, so the path
+ * of the new node is rebuilt from there only.
+ */
+template<typename T>
+RBTreeIterator<T> RBTree<T>::insert(iterator hint, const T& t) {
+	auto& path = hint.path;
+
+	/* The links from a parent on the path to its child on the path. The
+	   iterator only holds const nodes, but they are this tree's own. */
+	auto link_to = [this, &path](size_t i) -> std::unique_ptr<RBNode<T>>& {
+		if(i == 0)
+			return root;
+		auto p = const_cast<RBNode<T>*>(path[i - 1]);
+		return p->left.get() == path[i] ? p->left : p->right;
+	};
+
+	hint.reserve();
+	if(!path.empty())
+		hint.cut(climb(hint, t) + 1);
+
+	if(descend(hint, t))
+		return hint;
+
+	std::unique_ptr<RBNode<T>>* link = &root;
+	if(!path.empty()) {
+		auto p = const_cast<RBNode<T>*>(path.back());
+		link = t < p->key ? &p->left : &p->right;
+	}
+	*link = std::make_unique<RBNode<T>>(t);
+
+	size_t depth = path.size();
+	while(depth > 0) {
+		link = &link_to(--depth);
+		RBNode<T>::fix_up(*link);
+		if(!RBNode<T>::is_red(*link))
+			break;
+	}
+
+	root->color = BLK;
+
+	hint.cut(depth);
+	hint.push(link->get());
+	descend(hint, t);
+
+	hint.root = root.get();
+	return hint;
+}
+
+/**
+ * An iterative in-order walk that checks, at every node:
+ *
+ *   - the keys are strictly increasing,
+ *   - no red node has a red child,
+ *   - a red right child has a red left sibling (left-leaning),
+ *   - every null link is under the same number of black nodes,
+ *
+ * and that the root is black. It stops at the first violation. A tree too
+ * deep for the fixed-size stack cannot be balanced, and is reported as
+ * such.
+ */
+template<typename T>
+RBTreeStats RBTree<T>::validate() const {
+    struct Frame {
+        const RBNode<T>* node;
+        size_t depth;
+        size_t blacks;      /* Black nodes from the root down to node */
+    };
+
+    RBTreeStats st;
+    Frame stack[RB_MAX_DEPTH];
+    size_t top = 0;
+    const T* prev = nullptr;
+    bool seen_null = false;
+
+    auto fail = [&st](const char* error) {
+        st.valid = false;
+        st.error = error;
+    };
+
+    auto check_null = [&](size_t blacks) {
+        if (!seen_null) {
+            st.black_height = blacks;
+            seen_null = true;
+        } else if (blacks != st.black_height) {
+            fail("black balance");
+        }
+    };
+
+    /* Push n and its left spine */
+    auto push_left = [&](const RBNode<T>* n, size_t depth, size_t blacks) {
+        for (; n && st.valid; n = n->left.get()) {
+            if (top == RB_MAX_DEPTH) {
+                fail("depth");
+                return;
+            }
+
+            depth++;
+            blacks += n->color == BLK;
+            stack[top++] = { n, depth, blacks };
+
+            if (!n->left)
+                check_null(blacks);
+        }
+    };
+
+    if (RBNode<T>::is_red(root))
+        fail("red root");
+
+    push_left(root.get(), 0, 0);
+
+    while (top > 0 && st.valid) {
+        Frame f = stack[--top];
+        const RBNode<T>* n = f.node;
+
+        if (prev && !(*prev < n->key))
+            fail("key order");
+        prev = &n->key;
+
+        if (n->color == RED &&
+            (RBNode<T>::is_red(n->left) || RBNode<T>::is_red(n->right)))
+            fail("red node with a red child");
+        else if (RBNode<T>::is_red(n->right) && !RBNode<T>::is_red(n->left))
+            fail("right-leaning red link");
+
+        st.size++;
+        st.num_red += n->color == RED;
+        st.max_depth = std::max(st.max_depth, f.depth);
+
+        if (!n->right)
+            check_null(f.blacks);
+
+        push_left(n->right.get(), f.depth, f.blacks);
+    }
+
+    return st;
+}
+
 template<typename T>
 void RBTree<T>::traverse_inorder(std::function<void(RBNode<T>*)> f) {
     if (root)
@@ -377,51 +1039,50 @@ size_t RBNode<T>::get_max_depth() {
         return 1 + right->get_max_depth();
 }
 
+/**
+ * A breadth-first walk, with one line per level. A null child of a node is
+ * printed as "-", and the children of null links are not printed at all,
+ * so the work is linear in the number of nodes. The entries of a level
+ * past max_width are only counted.
+ */
 template<typename T>
-std::unordered_map<size_t, const RBNode<T>&>
-RBNode<T>::get_nodes_at_level(size_t lvl) {
-    std::unordered_map<size_t, const RBNode<T>&> ns;
-
-    _get_nodes_at_level(lvl, ns, Path{});
-
-    return ns;
-}
-
-template<typename T>
-void RBNode<T>::_get_nodes_at_level(
-    size_t lvl, std::unordered_map<size_t, const RBNode<T>&>& ns, Path sp) {
-    if (lvl == 0) {
-        ns.insert({ sp.p_, std::as_const(*this) });
-        return;
-    }
-
-    if (left)
-        left->_get_nodes_at_level(lvl - 1, ns, Path::down_left(sp, color));
-
-    if (right)
-        right->_get_nodes_at_level(lvl - 1, ns, Path::down_right(sp, color));
-}
-
-template<typename T>
-std::string RBNode<T>::format_level(size_t lvl) {
-    static const std::string red = "\033[1;31m";
-    static const std::string reset = "\033[0m";
-
-    std::ostringstream os;
-
-    auto ns = get_nodes_at_level(lvl);
-    for (auto i = 0; i < (1 << lvl); i++) {
-        const auto& pn = ns.find(i);
-        if (pn != ns.end()) {
-            const auto& n = pn->second;
-            if (n.color == RED) os << red << n.key << reset << ' ';
-            else os << n.key << ' ';
-        } else {
-            os << "- ";
+void RBNode<T>::write_levels(std::ostream& os, size_t max_width) const {
+    static const char* red = "\033[1;31m";
+    static const char* reset = "\033[0m";
+
+    std::vector<const RBNode*> level{ this }, next;
+
+    while (!level.empty()) {
+        size_t width = std::min(level.size(), max_width);
+
+        for (size_t i = 0; i < width; i++) {
+            const RBNode* n = level[i];
+            if (!n)
+                os << "- ";
+            else if (n->color == RED)
+                os << red << n->key << reset << ' ';
+            else
+                os << n->key << ' ';
         }
-    }
+        if (width < level.size())
+            os << "... (" << level.size() - width << " more)";
+        os << '\n';
+
+        /* A level of null links only is the end */
+        next.clear();
+        bool any = false;
+        for (const RBNode* n : level) {
+            if (!n)
+                continue;
+            next.push_back(n->left.get());
+            next.push_back(n->right.get());
+            any |= n->left || n->right;
+        }
+        if (!any)
+            next.clear();
 
-    return os.str();
+        level.swap(next);
+    }
 }
 
 template<typename T>
@@ -465,69 +1126,156 @@ RBNode<T>::RBNode(const T& t)
 
 template<typename T>
 std::ostream& operator<<(std::ostream& os, const RBTree<T>& rbtree) {
-    if (!rbtree.root)
-        return os;
-
-    auto max_depth = rbtree.root->get_max_depth();
-    for (auto i = 0; i < max_depth; i++)
-        os << rbtree.root->format_level(i) << '\n';
+    if (rbtree.root)
+        rbtree.root->write_levels(os, RB_LEVEL_WIDTH);
 
     return os;
 }
 
 template<typename T>
 std::ostream& operator<<(std::ostream& os, const RBNode<T>& rbnode) {
-    auto max_depth = rbnode.get_max_depth();
-    for (auto i = 0; i < max_depth; i++)
-        os << rbnode.format_level(i) << '\n';
-
+    rbnode.write_levels(os, RB_LEVEL_WIDTH);
     return os;
 }
 
 template <typename T>
-std::string RBTree<T>::format_graphviz() {
+std::string RBTree<T>::format_graphviz() const {
+    if (!root)
+        return "None\n";
+
     std::ostringstream os;
-    if(!root) {
-        os << "None\n";
-        return os.str();
-    }
+    write_graphviz(os);
+    return os.str();
+}
+
+template <typename T>
+void RBTree<T>::write_graphviz(std::ostream& os, size_t max_depth) const {
+    size_t null_id = 0;
+
     os << "graph RBTree {\n"
-       << "\tnode [fontname=\"Arial\"];\n"
-       << root->format_graphviz()
-       << "}\n";
+       << "\tnode [fontname=\"Arial\"];\n";
+    if (root && max_depth > 0)
+        root->write_graphviz(os, null_id, max_depth - 1);
+    os << "}\n";
+}
 
-    return os.str();
+template <typename T>
+void RBNode<T>::write_graphviz(std::ostream& os, size_t& null_id,
+                               size_t max_depth) const {
+    for (const RBNode* child : { left.get(), right.get() }) {
+        if (!child) {
+            size_t id = null_id++;
+            os << "\tnull" << id << "[shape=point];\n"
+               << '\t' << key << " -- null" << id << ";\n";
+        } else if (max_depth == 0) {
+            /* The subtree is cut here */
+            size_t id = null_id++;
+            os << "\tmore" << id << "[shape=triangle,label=\"\"];\n"
+               << '\t' << key << " -- more" << id << ";\n";
+        } else {
+            os << '\t' << key << " -- " << child->key
+               << (child->color == RED ? "[color=red,penwidth=3.0];\n"
+                                       : "[penwidth=3.0];\n");
+            child->write_graphviz(os, null_id, max_depth - 1);
+        }
+    }
 }
 
+/**
+ * Every node is an object
+ *
+ *   {"key": k, "color": "red" | "black", "left": ..., "right": ...}
+ *
+ * where a null child is null, and a cut subtree is {"truncated": true}.
+ * An empty tree is null. Numeric keys are written as numbers, and other
+ * keys as the string operator<< gives for them.
+ */
 template <typename T>
-std::string RBNode<T>::format_graphviz() {
-    std::ostringstream os;
+void RBTree<T>::write_json(std::ostream& os, size_t max_depth) const {
+    if (root && max_depth > 0)
+        root->write_json(os, max_depth - 1);
+    else if (root)
+        os << "{\"truncated\":true}";
+    else
+        os << "null";
+    os << '\n';
+}
 
-    if(left) {
-        os << '\t' << key << " -- " << left->key;
-        if(is_red(left))
-            os << "[color=red,penwidth=3.0]";
-        else
-            os << "[penwidth=3.0]";
-        os << ";\n" << left->format_graphviz();
-    } else {
-        os << "\tnull" << null_count << "[shape=point];\n"
-           << "\t" << key << " -- " << "null" << null_count++ << ";\n";
+/* Writes code point c inside a JSON string */
+static inline void write_json_char(std::ostream& os, uint32_t c) {
+    if (c == '"' || c == '\\') {
+        os << '\\' << (char)c;
+        return;
+    }
+    if (c >= 0x20 && c < 0x7f) {
+        os << (char)c;
+        return;
     }
 
-    if(right) {
-        os << '\t' << key << " -- " << right->key;
-        if(is_red(right))
-            os << "[color=red,penwidth=3.0]";
-        else
-            os << "[penwidth=3.0]";
-        os << ";\n" << right->format_graphviz();
+    char esc[16];
+    if (c < 0x10000)
+        snprintf(esc, sizeof(esc), "\\u%04x", (unsigned)c);
+    else    /* A surrogate pair */
+        snprintf(esc, sizeof(esc), "\\u%04x\\u%04x",
+                 (unsigned)(0xd800 + ((c - 0x10000) >> 10)),
+                 (unsigned)(0xdc00 + ((c - 0x10000) & 0x3ff)));
+    os << esc;
+}
+
+template <typename K>
+static constexpr bool rb_is_char_v =
+    std::is_same_v<K, char> || std::is_same_v<K, signed char> ||
+    std::is_same_v<K, unsigned char> || std::is_same_v<K, wchar_t> ||
+    std::is_same_v<K, char16_t> || std::is_same_v<K, char32_t>;
+
+/* Numbers as numbers, bools as true or false, and characters and other
+   keys as strings */
+template <typename K>
+static void write_json_key(std::ostream& os, const K& key) {
+    if constexpr (std::is_same_v<K, bool>) {
+        os << (key ? "true" : "false");
+    } else if constexpr (rb_is_char_v<K>) {
+        os << '"';
+        write_json_char(os, (uint32_t)(std::make_unsigned_t<K>)key);
+        os << '"';
+    } else if constexpr (std::is_arithmetic_v<K>) {
+        os << key;
     } else {
-        os << "\tnull" << null_count << "[shape=point];\n"
-           << "\t" << key << " -- " << "null" << null_count++ << ";\n";
+        std::ostringstream ks;
+        ks << key;
+
+        /* Bytes from 0x80 on are left as they are, for UTF-8 */
+        os << '"';
+        for (char c : ks.str()) {
+            if ((unsigned char)c < 0x80)
+                write_json_char(os, (unsigned char)c);
+            else
+                os << c;
+        }
+        os << '"';
     }
+}
 
-    return os.str();
+template <typename T>
+void RBNode<T>::write_json(std::ostream& os, size_t max_depth) const {
+    os << "{\"key\":";
+    write_json_key(os, key);
+    os << ",\"color\":" << (color == RED ? "\"red\"" : "\"black\"");
+
+    auto write_child = [&os, max_depth](const char* name, const RBNode* child) {
+        os << ",\"" << name << "\":";
+        if (!child)
+            os << "null";
+        else if (max_depth == 0)
+            os << "{\"truncated\":true}";
+        else
+            child->write_json(os, max_depth - 1);
+    };
+
+    write_child("left", left.get());
+    write_child("right", right.get());
+
+    os << '}';
 }
 
 #endif // __RBTREE_H_
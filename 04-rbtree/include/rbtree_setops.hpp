@@ -0,0 +1,343 @@
+#ifndef __RBTREE_SETOPS_H_
+#define __RBTREE_SETOPS_H_
+
+#include <cstddef>
+#include <future>
+#include <memory>
+#include <thread>
+#include <utility>
+
+#include "rbtree.hpp"
+
+/* Join-based bulk operations on RBTree.
+ *
+ * Everything is built on join(L, k, R), which links two trees and a key
+ * between them in O(|bh(L) - bh(R)| + 1), and on split(T, k), which cuts T
+ * into the keys less and greater than k in O(log n). Union, intersection
+ * and difference split one tree by the root of the other, recurse on both
+ * halves independently, and join the results. That takes O(m log(n/m + 1))
+ * work for trees of sizes m <= n, and the two recursive calls run in
+ * parallel near the top of the recursion.
+ *
+ * All the operations consume their input trees and reuse their nodes; no
+ * node is allocated. */
+
+template<typename T>
+using RBLink = std::unique_ptr<RBNode<T>>;
+
+/* A subtree with a black root (or empty), and its black height: the number
+   of black nodes on any path from the root down to a null link */
+template<typename T>
+struct RBSubtree {
+    RBLink<T> root;
+    size_t bh = 0;
+};
+
+template<typename T>
+struct RBSplit {
+    RBSubtree<T> left;
+    RBLink<T> node;     /* The node holding the key, if it was found */
+    RBSubtree<T> right;
+};
+
+/* Subtrees at least this tall (about 2^10 keys and more) are worth a
+   thread of their own */
+static constexpr size_t RB_PARALLEL_MIN_BH = 10;
+
+namespace rbtree_setops {
+
+template<typename T>
+RBSubtree<T> make_subtree(RBLink<T> root) {
+    RBSubtree<T> t{ std::move(root), 0 };
+
+    if (t.root)
+        t.root->color = BLK;
+
+    for (const RBNode<T>* n = t.root.get(); n; n = n->left.get())
+        t.bh += n->color == BLK;
+
+    return t;
+}
+
+/* Detach the root from its subtrees, which get black roots of their own */
+template<typename T>
+void expose(RBSubtree<T>&& t, RBSubtree<T>& l, RBLink<T>& m, RBSubtree<T>& r) {
+    m = std::move(t.root);
+    l = { std::move(m->left), t.bh - 1 };
+    r = { std::move(m->right), t.bh - 1 };
+
+    if (RBNode<T>::is_red(l.root)) {
+        l.root->color = BLK;
+        l.bh++;
+    }
+}
+
+/**
+ * Link l, the single node m, and r, where every key of l is less than
+ * m->key and every key of r is greater.
+ *
+ * When the black heights differ, walk down the inner spine of the taller
+ * tree to the black node whose black height is that of the shorter one,
+ * and replace it with m, painted red, holding both. From there, this is
+ * the same as an insertion: fix up the spine until a subtree root stays
+ * black.
+ */
+template<typename T>
+RBSubtree<T> join(RBSubtree<T>&& l, RBLink<T>&& m, RBSubtree<T>&& r) {
+    if (l.bh == r.bh) {
+        m->left = std::move(l.root);
+        m->right = std::move(r.root);
+        m->color = BLK;
+        return { std::move(m), l.bh + 1 };
+    }
+
+    RBLink<T>* path[RB_MAX_DEPTH];
+    size_t depth = 0;
+    RBSubtree<T> res;
+    RBLink<T>* link;
+
+    if (l.bh > r.bh) {
+        res = std::move(l);
+        link = &res.root;
+
+        /* Right links are black, so every step down loses one */
+        for (size_t h = res.bh; h > r.bh; h--) {
+            path[depth++] = link;
+            link = &(*link)->right;
+        }
+
+        m->left = std::move(*link);
+        m->right = std::move(r.root);
+    } else {
+        res = std::move(r);
+        link = &res.root;
+
+        for (size_t h = res.bh; h > l.bh; h--) {
+            path[depth++] = link;
+            link = &(*link)->left;
+
+            /* Skip the red link of a 3-node */
+            if (RBNode<T>::is_red(*link)) {
+                path[depth++] = link;
+                link = &(*link)->left;
+            }
+        }
+
+        m->left = std::move(l.root);
+        m->right = std::move(*link);
+    }
+
+    m->color = RED;
+    *link = std::move(m);
+
+    while (depth > 0) {
+        link = path[--depth];
+        RBNode<T>::fix_up(*link);
+        if (!RBNode<T>::is_red(*link))
+            break;
+    }
+
+    if (RBNode<T>::is_red(res.root)) {
+        res.root->color = BLK;
+        res.bh++;
+    }
+
+    return res;
+}
+
+template<typename T, typename K>
+RBSplit<T> split(RBSubtree<T>&& t, const K& k) {
+    if (!t.root)
+        return {};
+
+    RBSubtree<T> l, r;
+    RBLink<T> m;
+    expose(std::move(t), l, m, r);
+
+    if (k < m->key) {
+        auto s = split(std::move(l), k);
+        s.right = join(std::move(s.right), std::move(m), std::move(r));
+        return s;
+    }
+
+    if (m->key < k) {
+        auto s = split(std::move(r), k);
+        s.left = join(std::move(l), std::move(m), std::move(s.left));
+        return s;
+    }
+
+    return { std::move(l), std::move(m), std::move(r) };
+}
+
+/* Detach the node with the greatest key. t must not be empty. */
+template<typename T>
+RBSubtree<T> split_last(RBSubtree<T>&& t, RBLink<T>& last) {
+    RBSubtree<T> l, r;
+    RBLink<T> m;
+    expose(std::move(t), l, m, r);
+
+    if (!r.root) {
+        last = std::move(m);
+        return l;
+    }
+
+    auto rest = split_last(std::move(r), last);
+    return join(std::move(l), std::move(m), std::move(rest));
+}
+
+/* join without a middle key */
+template<typename T>
+RBSubtree<T> join2(RBSubtree<T>&& l, RBSubtree<T>&& r) {
+    if (!l.root)
+        return std::move(r);
+
+    RBLink<T> last;
+    auto rest = split_last(std::move(l), last);
+    return join(std::move(rest), std::move(last), std::move(r));
+}
+
+/* Run f and g, in parallel if there are threads to spare and the work is
+   large enough */
+template<typename F, typename G>
+void fork_join(size_t threads, size_t bh, F&& f, G&& g) {
+    if (threads < 2 || bh < RB_PARALLEL_MIN_BH) {
+        f();
+        g();
+        return;
+    }
+
+    auto future = std::async(std::launch::async, std::forward<F>(f));
+    g();
+    future.get();
+}
+
+template<typename T>
+RBSubtree<T> set_union(RBSubtree<T>&& a, RBSubtree<T>&& b, size_t threads) {
+    if (!a.root)
+        return std::move(b);
+    if (!b.root)
+        return std::move(a);
+
+    size_t bh = b.bh;
+    RBSubtree<T> bl, br, l, r;
+    RBLink<T> m;
+    expose(std::move(b), bl, m, br);
+
+    /* A node of a with the same key is dropped */
+    auto s = split(std::move(a), m->key);
+
+    fork_join(threads, bh,
+        [&] { l = set_union(std::move(s.left), std::move(bl), threads / 2); },
+        [&] { r = set_union(std::move(s.right), std::move(br), threads - threads / 2); });
+
+    return join(std::move(l), std::move(m), std::move(r));
+}
+
+template<typename T>
+RBSubtree<T> set_intersection(RBSubtree<T>&& a, RBSubtree<T>&& b,
+                              size_t threads) {
+    if (!a.root || !b.root)
+        return {};
+
+    size_t bh = b.bh;
+    RBSubtree<T> bl, br, l, r;
+    RBLink<T> m;
+    expose(std::move(b), bl, m, br);
+
+    auto s = split(std::move(a), m->key);
+
+    fork_join(threads, bh,
+        [&] { l = set_intersection(std::move(s.left), std::move(bl), threads / 2); },
+        [&] { r = set_intersection(std::move(s.right), std::move(br), threads - threads / 2); });
+
+    if (s.node)
+        return join(std::move(l), std::move(s.node), std::move(r));
+
+    return join2(std::move(l), std::move(r));
+}
+
+/* The keys of a that are not in b */
+template<typename T>
+RBSubtree<T> set_difference(RBSubtree<T>&& a, RBSubtree<T>&& b,
+                            size_t threads) {
+    if (!a.root || !b.root)
+        return std::move(a);
+
+    size_t bh = b.bh;
+    RBSubtree<T> bl, br, l, r;
+    RBLink<T> m;
+    expose(std::move(b), bl, m, br);
+
+    auto s = split(std::move(a), m->key);
+
+    fork_join(threads, bh,
+        [&] { l = set_difference(std::move(s.left), std::move(bl), threads / 2); },
+        [&] { r = set_difference(std::move(s.right), std::move(br), threads - threads / 2); });
+
+    return join2(std::move(l), std::move(r));
+}
+
+template<typename T>
+RBTree<T> to_tree(RBSubtree<T>&& t) {
+    RBTree<T> tree;
+    tree.root = std::move(t.root);
+    return tree;
+}
+
+} // namespace rbtree_setops
+
+static inline size_t rbtree_default_threads() {
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/* Every key of l must be less than k, and every key of r greater */
+template<typename T>
+RBTree<T> rbtree_join(RBTree<T>&& l, const T& k, RBTree<T>&& r) {
+    using namespace rbtree_setops;
+
+    return to_tree(join(make_subtree(std::move(l.root)),
+                        std::make_unique<RBNode<T>>(k),
+                        make_subtree(std::move(r.root))));
+}
+
+/* Move the keys of t less than k to l, and those greater than k to r.
+   Returns whether k was in t. */
+template<typename T>
+bool rbtree_split(RBTree<T>&& t, const T& k, RBTree<T>& l, RBTree<T>& r) {
+    using namespace rbtree_setops;
+
+    auto s = split(make_subtree(std::move(t.root)), k);
+    l = to_tree(std::move(s.left));
+    r = to_tree(std::move(s.right));
+
+    return s.node != nullptr;
+}
+
+template<typename T>
+RBTree<T> rbtree_union(RBTree<T>&& a, RBTree<T>&& b,
+                       size_t threads = rbtree_default_threads()) {
+    using namespace rbtree_setops;
+
+    return to_tree(set_union(make_subtree(std::move(a.root)),
+                             make_subtree(std::move(b.root)), threads));
+}
+
+template<typename T>
+RBTree<T> rbtree_intersection(RBTree<T>&& a, RBTree<T>&& b,
+                              size_t threads = rbtree_default_threads()) {
+    using namespace rbtree_setops;
+
+    return to_tree(set_intersection(make_subtree(std::move(a.root)),
+                                    make_subtree(std::move(b.root)), threads));
+}
+
+template<typename T>
+RBTree<T> rbtree_difference(RBTree<T>&& a, RBTree<T>&& b,
+                            size_t threads = rbtree_default_threads()) {
+    using namespace rbtree_setops;
+
+    return to_tree(set_difference(make_subtree(std::move(a.root)),
+                                  make_subtree(std::move(b.root)), threads));
+}
+
+#endif // __RBTREE_SETOPS_H_
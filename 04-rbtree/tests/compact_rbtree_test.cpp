@@ -0,0 +1,78 @@
+#include "compact_rbtree.hpp"
+
+#include <algorithm>
+#include <random>
+#include <set>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+/* Returns the black height of the subtree at n, or -1 if the subtree is not
+   a left-leaning red-black tree */
+template<typename T>
+static int check_subtree(const CompactRBTree<T>& tree, uint32_t n) {
+    if (n == CompactRBTree<T>::NIL)
+        return 0;
+
+    uint32_t l = tree.left(n), r = tree.right(n);
+
+    if (tree.is_red(r) && !tree.is_red(l))
+        return -1;
+    if (tree.is_red(n) && (tree.is_red(l) || tree.is_red(r)))
+        return -1;
+
+    int lh = check_subtree(tree, l), rh = check_subtree(tree, r);
+    if (lh < 0 || lh != rh)
+        return -1;
+
+    return lh + !tree.is_red(n);
+}
+
+TEST_CASE("Compact tree invariants", "[compact_rbtree]") {
+    CompactRBTree<int> tree;
+    std::vector<int> xs;
+    size_t n = 100'000;
+
+    for (auto i = 0; i < n; i++)
+        xs.push_back(i);
+
+    std::mt19937 g(0);
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    for (auto x : xs)
+        REQUIRE(tree.insert(x));
+
+    REQUIRE(tree.size() == n);
+    REQUIRE(!tree.is_red(tree.get_root()));
+    REQUIRE(check_subtree(tree, tree.get_root()) > 0);
+
+    std::vector<int> ys;
+    tree.traverse_inorder([&ys](int x) { ys.push_back(x); });
+
+    std::sort(xs.begin(), xs.end());
+    REQUIRE(xs == ys);
+}
+
+TEST_CASE("Compact tree lookups", "[compact_rbtree]") {
+    CompactRBTree<int> tree;
+    std::set<int> ref;
+
+    std::mt19937 g(1);
+    std::uniform_int_distribution<int> keys(0, 20'000);
+
+    for (auto i = 0; i < 10'000; i++) {
+        int x = keys(g);
+        REQUIRE(tree.insert(x) == ref.insert(x).second);
+    }
+
+    for (auto x = 0; x <= 20'000; x++)
+        REQUIRE(tree.contains(x) == (ref.count(x) == 1));
+
+    REQUIRE(tree.size() == ref.size());
+    REQUIRE(check_subtree(tree, tree.get_root()) > 0);
+}
+
+TEST_CASE("Compact node size", "[compact_rbtree]") {
+    REQUIRE(sizeof(CompactRBNode<int>) == 12);
+}
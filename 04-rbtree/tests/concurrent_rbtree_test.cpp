@@ -0,0 +1,186 @@
+#include "concurrent_rbtree.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <random>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+static constexpr size_t NUM_THREADS = 4;
+
+/* Returns the black height of the subtree at n, or -1 if the subtree is not
+   a left-leaning red-black tree */
+template<typename T>
+static int check_subtree(const ConcurrentRBNode<T>* n) {
+    if (!n)
+        return 0;
+
+    auto red = [](const ConcurrentRBNode<T>* x) { return x && x->color == RED; };
+
+    if (red(n->right) && !red(n->left))
+        return -1;
+    if (red(n) && (red(n->left) || red(n->right)))
+        return -1;
+
+    int lh = check_subtree(n->left), rh = check_subtree(n->right);
+    if (lh < 0 || lh != rh)
+        return -1;
+
+    return lh + !red(n);
+}
+
+TEST_CASE("Sequential operations", "[concurrent_rbtree]") {
+    ConcurrentRBTree<int> tree;
+    std::set<int> ref;
+
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> keys(0, 2'000);
+
+    for (auto i = 0; i < 50'000; i++) {
+        int x = keys(g);
+        if (g() % 2)
+            REQUIRE(tree.insert(x) == ref.insert(x).second);
+        else
+            REQUIRE(tree.remove(x) == (ref.erase(x) == 1));
+
+        if (i % 500 == 0)
+            REQUIRE(check_subtree(tree.get_root()) >= 0);
+    }
+
+    std::vector<int> xs;
+    tree.for_all([&xs](int x) { xs.push_back(x); });
+
+    REQUIRE(xs == std::vector<int>(ref.begin(), ref.end()));
+    REQUIRE(tree.size() == ref.size());
+}
+
+template<typename T>
+static void collect(const ConcurrentRBNode<T>* n, std::vector<T>& keys) {
+    if (!n)
+        return;
+    collect(n->left, keys);
+    keys.push_back(n->key);
+    collect(n->right, keys);
+}
+
+TEST_CASE("Removals leave older versions intact", "[concurrent_rbtree]") {
+    ConcurrentRBTree<std::string> tree;
+    std::vector<std::string> keys;
+
+    /* Long enough to be moved rather than copied in place */
+    for (auto i = 0; i < 1'000; i++) {
+        keys.push_back("a key that does not fit inline " + std::to_string(i));
+        tree.insert(keys.back());
+    }
+    std::sort(keys.begin(), keys.end());
+
+    std::mt19937 g(0);
+    std::vector<std::string> order = keys;
+    std::shuffle(order.begin(), order.end(), g);
+
+    for (const auto& k : order) {
+        /* Keeps the version before the removal from being reclaimed */
+        RBEpochGuard guard;
+        auto old_root = tree.get_root();
+        std::vector<std::string> before;
+        collect(old_root, before);
+
+        tree.remove(k);
+
+        std::vector<std::string> after;
+        collect(old_root, after);
+        REQUIRE(after == before);
+    }
+
+    REQUIRE(tree.size() == 0);
+}
+
+TEST_CASE("Nested reads keep the outer epoch", "[concurrent_rbtree]") {
+    ConcurrentRBTree<std::string> tree;
+    auto& domain = RBEpochDomain::instance();
+
+    for (auto i = 0; i < 1'000; i++)
+        tree.insert("a key that does not fit inline " + std::to_string(i));
+
+    RBEpochGuard guard;
+    uint64_t entered = domain.current();
+    auto old_root = tree.get_root();
+    std::vector<std::string> before;
+    collect(old_root, before);
+
+    /* Enough removals to reclaim several batches, each after a read that
+       enters and leaves its own guard */
+    for (auto i = 0; i < 500; i++) {
+        auto k = "a key that does not fit inline " + std::to_string(i);
+        REQUIRE(tree.contains(k));
+        REQUIRE(domain.min_active() <= entered);
+        tree.remove(k);
+    }
+
+    std::vector<std::string> after;
+    collect(old_root, after);
+    REQUIRE(after == before);
+}
+
+TEST_CASE("Readers during concurrent writes", "[concurrent_rbtree]") {
+    ConcurrentRBTree<int> tree;
+    int N = 100'000;
+    std::atomic<bool> done{false};
+    std::atomic<size_t> false_positives{0}, misses{0}, broken{0};
+
+    /* Multiples of 4 stay, odd keys are never inserted, and the other even
+       keys come and go */
+    for (auto i = 0; i < N; i += 2)
+        tree.insert(i);
+
+    std::vector<std::thread> readers;
+    for (size_t t = 0; t < NUM_THREADS - 1; t++) {
+        readers.emplace_back([&, t] {
+            std::mt19937 g(t);
+            std::uniform_int_distribution<int> dist(0, N - 1);
+
+            while (!done) {
+                int x = dist(g);
+                bool found = tree.contains(x);
+                if (x % 4 == 0 && !found)
+                    misses++;
+                if (x % 2 != 0 && found)
+                    false_positives++;
+
+                /* Every snapshot is sorted */
+                if (x % 8192 == 0) {
+                    int prev = -1;
+                    tree.for_all([&](int y) {
+                        if (y <= prev)
+                            broken++;
+                        prev = y;
+                    });
+                }
+            }
+        });
+    }
+
+    std::mt19937 g(NUM_THREADS);
+    std::uniform_int_distribution<int> dist(0, N / 4 - 1);
+    for (auto i = 0; i < 50'000; i++) {
+        int x = 4 * dist(g) + 2;
+        if (g() % 2)
+            tree.insert(x);
+        else
+            tree.remove(x);
+    }
+
+    done = true;
+    for (auto& th : readers)
+        th.join();
+
+    REQUIRE(misses == 0);
+    REQUIRE(false_positives == 0);
+    REQUIRE(broken == 0);
+    REQUIRE(check_subtree(tree.get_root()) >= 0);
+}
@@ -0,0 +1,130 @@
+#include "rbmap.hpp"
+
+#include <iterator>
+#include <map>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+TEST_CASE("Map operations", "[rbmap]") {
+    RBMap<int, std::string> map;
+    std::map<int, std::string> ref;
+
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> keys(0, 2'000);
+    std::uniform_int_distribution<int> ops(0, 3);
+
+    for (auto i = 0; i < 50'000; i++) {
+        int k = keys(g);
+        std::string v = std::to_string(i);
+
+        switch (ops(g)) {
+        case 0:
+            REQUIRE(map.insert(k, v) == ref.insert({ k, v }).second);
+            break;
+        case 1:
+            REQUIRE(map.insert_or_assign(k, v) ==
+                    ref.insert_or_assign(k, v).second);
+            break;
+        case 2:
+            REQUIRE(map.erase(k) == (ref.erase(k) == 1));
+            break;
+        default:
+            map[k] += "!";
+            ref[k] += "!";
+            break;
+        }
+    }
+
+    REQUIRE(map.size() == ref.size());
+
+    for (auto k = 0; k <= 2'000; k++) {
+        auto it = map.find(k);
+        auto rit = ref.find(k);
+        REQUIRE((it == map.end()) == (rit == ref.end()));
+        if (rit != ref.end()) {
+            REQUIRE(it->key == k);
+            REQUIRE(map.at(k) == rit->second);
+        } else {
+            REQUIRE_THROWS_AS(map.at(k), std::out_of_range);
+        }
+    }
+
+    /* A const map hands out const values */
+    const auto& cmap = map;
+    static_assert(std::is_same_v<decltype(cmap.at(0)), const std::string&>);
+    static_assert(std::is_same_v<decltype(map.at(0)), std::string&>);
+    auto k = ref.begin()->first;
+    map.at(k) = "changed";
+    REQUIRE(cmap.at(k) == "changed");
+}
+
+TEST_CASE("Map iteration", "[rbmap]") {
+    RBMap<int, int> map;
+    std::map<int, int> ref;
+
+    std::mt19937 g(1);
+    std::uniform_int_distribution<int> keys(0, 1 << 20);
+
+    for (auto i = 0; i < 10'000; i++) {
+        int k = keys(g);
+        map.insert(k, i);
+        ref.insert({ k, i });
+    }
+
+    /* Forward */
+    auto it = map.begin();
+    for (const auto& [k, v] : ref) {
+        REQUIRE(it != map.end());
+        REQUIRE(it->key == k);
+        REQUIRE(it->value == v);
+        ++it;
+    }
+    REQUIRE(it == map.end());
+
+    /* Backward, starting from the end */
+    for (auto rit = ref.rbegin(); rit != ref.rend(); ++rit) {
+        --it;
+        REQUIRE(it->key == rit->first);
+    }
+    REQUIRE(it == map.begin());
+
+    REQUIRE(std::distance(map.begin(), map.end()) == ref.size());
+
+    /* Values can be updated through iterators */
+    for (auto& e : map)
+        e.value = -e.key;
+    REQUIRE(map.at(ref.begin()->first) == -ref.begin()->first);
+}
+
+TEST_CASE("Map bounds", "[rbmap]") {
+    RBMap<int, int> map;
+    std::map<int, int> ref;
+
+    for (auto k = 0; k < 1'000; k += 3) {
+        map.insert(k, k);
+        ref.insert({ k, k });
+    }
+
+    for (auto k = -2; k < 1'002; k++) {
+        auto lb = map.lower_bound(k);
+        auto rlb = ref.lower_bound(k);
+        REQUIRE((lb == map.end()) == (rlb == ref.end()));
+        if (rlb != ref.end())
+            REQUIRE(lb->key == rlb->first);
+
+        auto ub = map.upper_bound(k);
+        auto rub = ref.upper_bound(k);
+        REQUIRE((ub == map.end()) == (rub == ref.end()));
+        if (rub != ref.end())
+            REQUIRE(ub->key == rub->first);
+    }
+
+    RBMap<int, int> empty;
+    REQUIRE(empty.begin() == empty.end());
+    REQUIRE(empty.lower_bound(0) == empty.end());
+}
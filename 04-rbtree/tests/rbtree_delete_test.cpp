@@ -3,6 +3,7 @@
 #include <algorithm>
 #include <iostream>
 #include <random>
+#include <set>
 #include <vector>
 
 #define CATCH_CONFIG_MAIN
@@ -131,3 +132,31 @@ TEST_CASE("Inorder traversal after random deletions", "[rbtree]") {
 
     REQUIRE(zs == ys);
 }
+
+TEST_CASE("Random inserts and removals", "[rbtree]") {
+    RBTree<int> rbtree;
+    std::set<int> ref;
+    size_t n = 100'000;
+
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> keys(0, 1'000);
+    std::bernoulli_distribution coin(0.5);
+
+    for (auto i = 0; i < n; i++) {
+        int x = keys(g);
+        if (coin(g))
+            REQUIRE(rbtree.insert(x) == ref.insert(x).second);
+        else
+            REQUIRE(rbtree.remove(x) == (ref.erase(x) == 1));
+
+        if (i % 1'000 == 0) {
+            REQUIRE(test_left_lean(rbtree));
+            REQUIRE(test_black_balance(rbtree));
+        }
+    }
+
+    std::vector<int> zs;
+    rbtree.traverse_inorder([&zs](RBNode<int>* n) { zs.push_back(n->key); });
+
+    REQUIRE(zs == std::vector<int>(ref.begin(), ref.end()));
+}
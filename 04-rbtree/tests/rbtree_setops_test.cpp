@@ -0,0 +1,99 @@
+#include "rbtree_setops.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <random>
+#include <set>
+#include <vector>
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "rbtree_test_util.hpp"
+
+static std::vector<int> random_keys(size_t n, int max_key, unsigned seed) {
+    std::mt19937 g(seed);
+    std::uniform_int_distribution<int> dist(0, max_key);
+    std::set<int> keys;
+
+    while (keys.size() < n)
+        keys.insert(dist(g));
+
+    std::vector<int> xs(keys.begin(), keys.end());
+    std::shuffle(xs.begin(), xs.end(), g);
+    return xs;
+}
+
+static RBTree<int> make_tree(const std::vector<int>& xs) {
+    RBTree<int> rbtree;
+    for (auto x : xs)
+        rbtree.insert(x);
+    return rbtree;
+}
+
+static std::vector<int> sorted(std::vector<int> xs) {
+    std::sort(xs.begin(), xs.end());
+    return xs;
+}
+
+static void check(const RBTree<int>& rbtree, const std::vector<int>& expected) {
+    REQUIRE(test_left_lean(rbtree));
+    REQUIRE(test_black_balance(rbtree));
+    REQUIRE(!RBNode<int>::is_red(rbtree.root));
+    REQUIRE(std::vector<int>(rbtree.begin(), rbtree.end()) == expected);
+}
+
+TEST_CASE("Join and split", "[rbtree_setops]") {
+    /* Even keys, so that odd ones are absent */
+    auto xs = sorted(random_keys(10'000, 1 << 20, 0));
+    for (auto& x : xs)
+        x *= 2;
+
+    for (size_t cut : { 0, 1, 37, 5'000, 9'999 }) {
+        std::vector<int> lo(xs.begin(), xs.begin() + cut);
+        std::vector<int> hi(xs.begin() + cut + 1, xs.end());
+
+        auto joined = rbtree_join(make_tree(lo), xs[cut], make_tree(hi));
+        check(joined, xs);
+
+        RBTree<int> l, r;
+        REQUIRE(rbtree_split(std::move(joined), xs[cut], l, r));
+        check(l, lo);
+        check(r, hi);
+
+        /* Split by an absent key */
+        lo.push_back(xs[cut]);
+        REQUIRE(!rbtree_split(make_tree(xs), xs[cut] + 1, l, r));
+        check(l, lo);
+        check(r, hi);
+    }
+}
+
+TEST_CASE("Union, intersection and difference", "[rbtree_setops]") {
+    for (auto [n, m] : { std::pair<size_t, size_t>{ 20'000, 20'000 },
+                         { 20'000, 100 }, { 100, 20'000 }, { 0, 1'000 },
+                         { 1'000, 0 } }) {
+        auto xs = random_keys(n, 100'000, n);
+        auto ys = random_keys(m, 100'000, m + 1);
+        auto sx = sorted(xs), sy = sorted(ys);
+
+        for (size_t threads : { 1, 4 }) {
+            std::vector<int> expected;
+            std::set_union(sx.begin(), sx.end(), sy.begin(), sy.end(),
+                           std::back_inserter(expected));
+            check(rbtree_union(make_tree(xs), make_tree(ys), threads), expected);
+
+            expected.clear();
+            std::set_intersection(sx.begin(), sx.end(), sy.begin(), sy.end(),
+                                  std::back_inserter(expected));
+            check(rbtree_intersection(make_tree(xs), make_tree(ys), threads),
+                  expected);
+
+            expected.clear();
+            std::set_difference(sx.begin(), sx.end(), sy.begin(), sy.end(),
+                                std::back_inserter(expected));
+            check(rbtree_difference(make_tree(xs), make_tree(ys), threads),
+                  expected);
+        }
+    }
+}
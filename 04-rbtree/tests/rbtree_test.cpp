@@ -1,7 +1,12 @@
 #include "rbtree.hpp"
 
+#include <algorithm>
 #include <iostream>
+#include <iterator>
 #include <random>
+#include <set>
+#include <sstream>
+#include <string>
 #include <vector>
 
 #define CATCH_CONFIG_MAIN
@@ -73,3 +78,241 @@ TEST_CASE("Left lean", "[rbtree]") {
 
     REQUIRE(test_left_lean(rbtree));
 }
+
+TEST_CASE("Iterators", "[rbtree]") {
+    RBTree<int> rbtree;
+    std::vector<int> xs;
+    size_t n = 10'000;
+
+    for (auto i = 0; i < n; i++)
+        xs.emplace_back(2 * i);
+
+    std::mt19937 g(0);
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    for (auto i : xs)
+        rbtree.insert(i);
+
+    std::vector<int> ys(rbtree.begin(), rbtree.end());
+    std::sort(xs.begin(), xs.end());
+    REQUIRE(xs == ys);
+
+    std::vector<int> zs;
+    for (auto it = rbtree.end(); it != rbtree.begin(); )
+        zs.push_back(*--it);
+    std::reverse(zs.begin(), zs.end());
+    REQUIRE(xs == zs);
+
+    REQUIRE(*rbtree.find(42) == 42);
+    REQUIRE(rbtree.find(43) == rbtree.end());
+    REQUIRE(*rbtree.lower_bound(43) == 44);
+    REQUIRE(*rbtree.upper_bound(44) == 46);
+    REQUIRE(rbtree.upper_bound(int(2 * (n - 1))) == rbtree.end());
+}
+
+TEST_CASE("Validate", "[rbtree]") {
+    RBTree<int> rbtree;
+    std::vector<int> xs;
+    size_t n = 100'000;
+
+    REQUIRE(rbtree.validate().valid);
+    REQUIRE(rbtree.validate().size == 0);
+
+    for (auto i = 0; i < n; i++)
+        xs.emplace_back(i);
+
+    std::mt19937 g(0);
+    std::shuffle(xs.begin(), xs.end(), g);
+
+    for (auto i : xs)
+        rbtree.insert(i);
+
+    auto st = rbtree.validate();
+    REQUIRE(st.valid);
+    REQUIRE(st.error == nullptr);
+    REQUIRE(st.size == n);
+    /* Path does not count the root */
+    REQUIRE(st.black_height == rbtree.collect_all_leaves().begin()->first.num_black_ + 1);
+    REQUIRE(st.max_depth <= 2 * 17);
+    REQUIRE(st.red_ratio() > 0);
+    REQUIRE(st.red_ratio() < 0.5);
+
+    /* Break the tree in a few ways */
+    rbtree.root->color = RED;
+    REQUIRE(std::string(rbtree.validate().error) == "red root");
+    rbtree.root->color = BLK;
+
+    auto& left = rbtree.root->left;
+    auto color = left->color;
+    left->color = !color;
+    REQUIRE(!rbtree.validate().valid);
+    left->color = color;
+
+    std::swap(rbtree.root->key, left->key);
+    REQUIRE(std::string(rbtree.validate().error) == "key order");
+    std::swap(rbtree.root->key, left->key);
+
+    REQUIRE(rbtree.validate().valid);
+}
+
+TEST_CASE("Export", "[rbtree]") {
+    RBTree<int> rbtree;
+
+    std::ostringstream empty;
+    rbtree.write_json(empty);
+    REQUIRE(empty.str() == "null\n");
+
+    for (auto i : { 2, 1, 3 })
+        rbtree.insert(i);
+
+    std::ostringstream json;
+    rbtree.write_json(json);
+    REQUIRE(json.str() ==
+        "{\"key\":2,\"color\":\"black\","
+        "\"left\":{\"key\":1,\"color\":\"black\",\"left\":null,\"right\":null},"
+        "\"right\":{\"key\":3,\"color\":\"black\",\"left\":null,\"right\":null}}\n");
+
+    std::ostringstream cut;
+    rbtree.write_json(cut, 1);
+    REQUIRE(cut.str() ==
+        "{\"key\":2,\"color\":\"black\","
+        "\"left\":{\"truncated\":true},\"right\":{\"truncated\":true}}\n");
+
+    for (auto i = 4; i <= 1000; i++)
+        rbtree.insert(i);
+
+    /* Every dump numbers its null links from 0 */
+    auto dot = rbtree.format_graphviz();
+    REQUIRE(dot == rbtree.format_graphviz());
+
+    size_t nulls = 0;
+    for (size_t pos = 0; (pos = dot.find("[shape=point]", pos)) != std::string::npos; pos++)
+        nulls++;
+    REQUIRE(nulls == 1001);
+    REQUIRE(dot.find("null1000[shape=point]") != std::string::npos);
+
+    std::ostringstream top;
+    rbtree.write_graphviz(top, 2);
+    REQUIRE(top.str().find("more3[shape=triangle") != std::string::npos);
+    REQUIRE(top.str().find("more4") == std::string::npos);
+
+    /* Keys that are not numbers are quoted and escaped */
+    RBTree<std::string> strings;
+    for (auto k : { "b", "a\"q", "c\\\n" })
+        strings.insert(k);
+
+    std::ostringstream quoted;
+    strings.write_json(quoted);
+    REQUIRE(quoted.str() ==
+        "{\"key\":\"b\",\"color\":\"black\","
+        "\"left\":{\"key\":\"a\\\"q\",\"color\":\"black\",\"left\":null,\"right\":null},"
+        "\"right\":{\"key\":\"c\\\\\\u000a\",\"color\":\"black\",\"left\":null,\"right\":null}}\n");
+
+    /* Characters are strings too, and bools are true or false */
+    RBTree<char> chars;
+    chars.insert('"');
+    std::ostringstream char_json;
+    chars.write_json(char_json);
+    REQUIRE(char_json.str() ==
+        "{\"key\":\"\\\"\",\"color\":\"black\",\"left\":null,\"right\":null}\n");
+
+    RBTree<char32_t> wide;
+    wide.insert(U'\U0001F600');
+    std::ostringstream wide_json;
+    wide.write_json(wide_json);
+    REQUIRE(wide_json.str().find("\"key\":\"\\ud83d\\ude00\"") != std::string::npos);
+
+    RBTree<bool> bools;
+    bools.insert(true);
+    std::ostringstream bool_json;
+    bools.write_json(bool_json);
+    REQUIRE(bool_json.str().find("\"key\":true,") != std::string::npos);
+}
+
+TEST_CASE("Print levels", "[rbtree]") {
+    RBTree<int> rbtree;
+
+    std::ostringstream empty;
+    empty << rbtree;
+    REQUIRE(empty.str().empty());
+
+    for (auto i : { 2, 1, 3, 4 })
+        rbtree.insert(i);
+
+    /* 3 is the red left child of 4 */
+    std::ostringstream small;
+    small << rbtree;
+    REQUIRE(small.str() == "2 \n1 4 \n- - \033[1;31m3\033[0m - \n");
+
+    /* A path of 100k levels would overflow 1 << lvl */
+    size_t n = 100'000;
+    for (auto i = 5; i <= n; i++)
+        rbtree.insert(i);
+
+    std::ostringstream big;
+    big << rbtree;
+    auto out = big.str();
+    REQUIRE(std::count(out.begin(), out.end(), '\n') == rbtree.validate().max_depth);
+    REQUIRE(out.find("more)") != std::string::npos);
+
+    std::ostringstream full;
+    rbtree.root->write_levels(full, RB_NO_DEPTH_LIMIT);
+    REQUIRE(full.str().find("more)") == std::string::npos);
+
+    /* Every key once, strip the colors */
+    auto out_full = full.str();
+    for (auto esc : { std::string("\033[1;31m"), std::string("\033[0m") })
+        for (size_t pos; (pos = out_full.find(esc)) != std::string::npos; )
+            out_full.erase(pos, esc.size());
+
+    std::istringstream in(out_full);
+    size_t keys = 0;
+    for (std::string tok; in >> tok; )
+        keys += tok != "-";
+    REQUIRE(keys == n);
+}
+
+TEST_CASE("Hinted insert and find", "[rbtree]") {
+    RBTree<int> rbtree;
+    std::set<int> ref;
+    size_t n = 100'000;
+
+    /* Nearly sorted, with duplicates */
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> jitter(-50, 50);
+
+    auto hint = rbtree.end();
+    for (auto i = 0; i < n; i++) {
+        int x = i + jitter(g);
+        hint = rbtree.insert(hint, x);
+        ref.insert(x);
+        REQUIRE(*hint == x);
+    }
+
+    auto st = rbtree.validate();
+    REQUIRE(st.valid);
+    REQUIRE(st.size == ref.size());
+    REQUIRE(std::equal(rbtree.begin(), rbtree.end(), ref.begin(), ref.end()));
+
+    /* Random hints and keys */
+    std::uniform_int_distribution<int> keys(-100, n + 100);
+    for (auto i = 0; i < 10'000; i++) {
+        int x = keys(g);
+        auto it = rbtree.find(rbtree.lower_bound(keys(g)), x);
+        if (ref.count(x)) {
+            REQUIRE(it != rbtree.end());
+            REQUIRE(*it == x);
+            REQUIRE(std::next(it) == rbtree.upper_bound(x));
+        } else {
+            REQUIRE(it == rbtree.end());
+        }
+
+        hint = rbtree.insert(rbtree.lower_bound(keys(g)), x);
+        ref.insert(x);
+        REQUIRE(*hint == x);
+        REQUIRE(std::next(hint) == rbtree.upper_bound(x));
+    }
+
+    REQUIRE(rbtree.validate().valid);
+    REQUIRE(std::equal(rbtree.begin(), rbtree.end(), ref.begin(), ref.end()));
+}
@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "hash_funcs.hpp"
+
+/* Usage: hash_funcs_bench [num_keys]
+ *
+ * Times each hasher on ints and on strings of 4 to 1024 bytes, and prints
+ * the time per hash and, for strings, the throughput. Then puts num_keys
+ * keys (2^16 by default) of a few patterns into a LinearProbeHashTable
+ * with each hasher, and prints the mean number of probes of a get and its
+ * time. */
+
+using Clock = std::chrono::steady_clock;
+
+static const size_t HASHES = 1 << 24;
+
+template <typename F, typename K>
+static double time_hashes(const std::vector<K>& keys, uint64_t& sink) {
+    F hash_func;
+    size_t rounds = std::max<size_t>(1, HASHES / keys.size());
+
+    auto start = Clock::now();
+    for (size_t r = 0; r < rounds; r++)
+        for (auto& k : keys)
+            sink += hash_func(k);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    return ns / (rounds * keys.size());
+}
+
+template <typename F>
+static void hash_speed(const char* name, uint64_t& sink) {
+    std::mt19937 g(0);
+    std::vector<int> ints(4096);
+    for (auto& k : ints)
+        k = (int)g();
+
+    printf("  %-8s %8.2f", name, time_hashes<F>(ints, sink));
+
+    for (size_t len : { 4, 8, 16, 32, 64, 256, 1024 }) {
+        std::vector<std::string> strings(std::max<size_t>(16, 65536 / len));
+        for (auto& s : strings) {
+            s.resize(len);
+            for (auto& c : s)
+                c = (char)g();
+        }
+
+        double ns = time_hashes<F>(strings, sink);
+        printf("  %6.1f %5.2f", ns, len / ns);
+    }
+    printf("\n");
+}
+
+template <typename F, typename K>
+static void probes(const std::vector<K>& keys, uint64_t& sink) {
+    LinearProbeHashTable<K, int, F> ht;
+    int value = 0;
+
+    for (auto& k : keys)
+        ht.put(k, 0);
+
+    double sum = 0;
+    auto start = Clock::now();
+    for (auto& k : keys) {
+        sum += ht.get(k, value);
+        sink += value;
+    }
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+
+    printf(" %9.2f %8.1f", sum / keys.size(), ns / keys.size());
+}
+
+template <typename K>
+static void probe_row(const char* pattern, const std::vector<K>& keys, uint64_t& sink) {
+    printf("  %-14s", pattern);
+    probes<DefaultHash>(keys, sink);
+    probes<MurmurHash>(keys, sink);
+    probes<WyHash>(keys, sink);
+    printf("\n");
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1 << 16;
+    uint64_t sink = 0;
+
+    printf("hash ns, and string hash ns and GB/s, by length\n");
+    printf("  %-8s %8s", "", "int");
+    for (auto len : { "4", "8", "16", "32", "64", "256", "1024" })
+        printf("  %12s", len);
+    printf("\n");
+    hash_speed<DefaultHash>("default", sink);
+    hash_speed<MurmurHash>("murmur", sink);
+    hash_speed<WyHash>("wy", sink);
+
+    std::vector<int> sequential, strided, high;
+    std::vector<std::string> numbered, anagrams;
+    for (size_t i = 0; i < n; i++) {
+        sequential.push_back((int)i);
+        strided.push_back((int)i * 64);
+        high.push_back((int)(i << 16));
+        numbered.push_back("key" + std::to_string(i));
+    }
+    std::string s = "abcdefgh";
+    do {
+        anagrams.push_back(s);
+    } while (anagrams.size() < n && std::next_permutation(s.begin(), s.end()));
+
+    printf("\nmean probes and ns of a get, linear probing\n");
+    printf("  %-14s %18s %18s %18s\n", "keys", "default", "murmur", "wy");
+    probe_row("sequential", sequential, sink);
+    probe_row("stride 64", strided, sink);
+    probe_row("i << 16", high, sink);
+    probe_row("\"key\" + i", numbered, sink);
+    probe_row("anagrams", anagrams, sink);
+
+    /* Keep the results alive */
+    if (sink == 0)
+        fputs("", stderr);
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "hash_funcs.hpp"
+
+/* Usage: hashtable_alloc_bench [num_keys]
+ *
+ * Puts num_keys string keys and values (1M by default), of 32 characters
+ * so that they are not stored inline, into a table and reads them back,
+ * through each of the ways to do so. Prints the heap allocations per
+ * operation, resizes included, and the time per operation. */
+
+using Clock = std::chrono::steady_clock;
+
+static size_t num_allocs = 0;
+
+void* operator new(size_t n) {
+    num_allocs++;
+    if (void* p = std::malloc(n ? n : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, size_t) noexcept {
+    std::free(p);
+}
+
+using Table = LinearProbeHashTable<std::string, std::string, MurmurHash>;
+
+static std::vector<std::string> make_strings(size_t n, char tag) {
+    std::vector<std::string> v;
+    v.reserve(n);
+    for (size_t i = 0; i < n; i++) {
+        std::string s = tag + std::to_string(i);
+        s.resize(32, '.');
+        v.push_back(std::move(s));
+    }
+    return v;
+}
+
+/* Runs f(i) for every key, and reports its allocations and time */
+template <typename Fn>
+static void measure(const char* name, size_t n, Fn&& f) {
+    size_t allocs = num_allocs;
+    auto start = Clock::now();
+    for (size_t i = 0; i < n; i++)
+        f(i);
+    double ns = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+    allocs = num_allocs - allocs;
+
+    printf("  %-32s %10.2f %10.1f\n", name, (double)allocs / n, ns / n);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t sink = 0;
+
+    const std::vector<std::string> keys = make_strings(n, 'k');
+    const std::vector<std::string> values = make_strings(n, 'v');
+
+    printf("  %-32s %10s %10s\n", "", "allocs/op", "ns/op");
+
+    {
+        Table ht;
+        std::string value;
+
+        measure("put", n, [&](size_t i) { ht.put(keys[i], values[i]); });
+        measure("get", n, [&](size_t i) { sink += ht.get(keys[i], value); });
+        measure("find", n, [&](size_t i) { sink += ht.find(keys[i])->size(); });
+    }
+
+    {
+        Table ht;
+        std::vector<std::string> k = keys, v = values;
+
+        measure("emplace, moving key and value", n, [&](size_t i) {
+            ht.emplace(std::move(k[i]), std::move(v[i]));
+        });
+
+        v = values;
+        measure("insert_or_assign, moving value", n, [&](size_t i) {
+            ht.insert_or_assign(keys[i], std::move(v[i]));
+        });
+    }
+
+    /* Keep the results alive */
+    if (sink == 0)
+        fputs("", stderr);
+
+    return 0;
+}
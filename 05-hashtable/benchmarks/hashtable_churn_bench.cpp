@@ -0,0 +1,82 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "hash_funcs.hpp"
+
+/* Usage: hashtable_churn_bench [num_keys] [num_rounds]
+ *
+ * Keeps num_keys random keys (100k by default) in the table while running
+ * num_rounds rounds (20 by default) of num_keys operations, each removing
+ * a random live key, inserting a new one, and looking up another live key.
+ * Prints, per round, the mean and tail latency of an operation, the table
+ * size, and the number of failed puts. Removed slots are reused and
+ * rehashed away, so the latency should stay flat; the maximum is a
+ * same-size rehash. */
+
+using Clock = std::chrono::steady_clock;
+
+template <typename HT>
+static void run(const char* name, size_t n, size_t rounds) {
+    HT ht;
+    std::mt19937 g(0);
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    std::vector<int> live;
+    std::vector<double> ns(n);
+    std::string value;
+    size_t failed = 0, sink = 0;
+
+    /* Distinct keys, spread over the int range */
+    unsigned next_key = 0;
+    auto key = [&next_key] { return (int)(next_key++ * 2654435761u); };
+
+    for (size_t i = 0; i < n; i++) {
+        live.push_back(key());
+        ht.put(live.back(), "v");
+    }
+
+    printf("%s\n  %-6s %9s %9s %9s %9s %10s %7s\n", name, "round", "mean ns",
+           "p50 ns", "p99 ns", "max ns", "table", "failed");
+
+    for (size_t r = 1; r <= rounds; r++) {
+        for (size_t i = 0; i < n; i++) {
+            size_t j = pick(g);
+            int k = key();
+
+            auto start = Clock::now();
+            ht.remove(live[j]);
+            if (ht.put(k, "v") >= 0)
+                live[j] = k;
+            else
+                failed++;
+            sink += ht.get(live[pick(g)], value);
+            ns[i] = std::chrono::duration<double, std::nano>(Clock::now() - start).count();
+        }
+
+        double mean = 0;
+        for (auto x : ns)
+            mean += x / n;
+        std::sort(ns.begin(), ns.end());
+
+        printf("  %-6zu %9.1f %9.1f %9.1f %9.1f %10zu %7zu\n", r, mean,
+               ns[n / 2], ns[n * 99 / 100], ns[n - 1], ht.get_table_size(), failed);
+    }
+
+    /* Keep the results alive */
+    if (sink == 0)
+        fputs("", stderr);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 100000;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 20;
+
+    run<LinearProbeHashTable<int, std::string, DefaultHash>>("linear", n, rounds);
+    run<QuadProbeHashTable<int, std::string, DefaultHash>>("quadratic", n, rounds);
+
+    return 0;
+}
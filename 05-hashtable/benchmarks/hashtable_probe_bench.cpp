@@ -0,0 +1,90 @@
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "hash_funcs.hpp"
+
+/* Usage: hashtable_probe_bench [log2_table_size] [num_lookups]
+ *
+ * Fills a table of 2^log2_table_size slots (2^20 by default) with random
+ * keys, from a load factor of 1/4, where it last doubled, to just under
+ * 1/2, where it doubles again. At every tenth of the way, times
+ * num_lookups gets (1M by default) of present keys and of absent ones.
+ * Prints the time per get, and for the present keys, the slots visited
+ * per get (the number of probes plus one) and the time per slot. */
+
+using Clock = std::chrono::steady_clock;
+
+template <typename HT>
+static double time_gets(HT& ht, const std::vector<int>& keys, size_t n,
+                        size_t& slots, size_t& sink) {
+    std::mt19937 g(1);
+    std::uniform_int_distribution<size_t> pick(0, keys.size() - 1);
+    int value = 0;
+
+    /* Keys are picked ahead, to keep the generator out of the timing */
+    std::vector<int> lookups(n);
+    for (auto& k : lookups)
+        k = keys[pick(g)];
+
+    slots = 0;
+    auto start = Clock::now();
+    for (auto k : lookups) {
+        slots += ht.get(k, value) + 1;
+        sink += value;
+    }
+
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+template <typename HT>
+static void run(const char* name, size_t log2_size, size_t n) {
+    HT ht;
+    std::mt19937 g(0);
+    std::vector<int> keys, misses;
+    size_t table_size = size_t{1} << log2_size;
+    size_t slots, sink = 0;
+
+    /* Present keys are odd, absent ones even */
+    while (misses.size() < 100000)
+        misses.push_back((int)(g() & ~1u));
+
+    printf("%s\n  %6s %9s %9s %9s %9s\n", name, "load", "hit ns", "slots",
+           "ns/slot", "miss ns");
+
+    for (size_t step = 0; step < 10; step++) {
+        size_t target = table_size / 4 + table_size * step / 40;
+        if (step == 9)
+            target = table_size / 2 - 1;
+
+        while (ht.get_size() < target) {
+            int k = (int)(g() | 1);
+            if (ht.put(k, k) >= 0)
+                keys.push_back(k);
+        }
+
+        double hit_ns = time_gets(ht, keys, n, slots, sink);
+        double hit_slots = (double)slots / n;
+        double miss_ns = time_gets(ht, misses, n, slots, sink);
+
+        printf("  %6.3f %9.1f %9.2f %9.2f %9.1f\n", ht.get_load_factor(),
+               hit_ns, hit_slots, hit_ns / hit_slots, miss_ns);
+    }
+
+    /* Keep the results alive */
+    if (sink == 0)
+        fputs("", stderr);
+}
+
+int main(int argc, char *argv[]) {
+    size_t log2_size = argc > 1 ? std::stoul(argv[1]) : 20;
+    size_t n = argc > 2 ? std::stoul(argv[2]) : 1000000;
+
+    run<LinearProbeHashTable<int, int, DefaultHash>>("linear", log2_size, n);
+    run<QuadProbeHashTable<int, int, DefaultHash>>("quadratic", log2_size, n);
+
+    return 0;
+}
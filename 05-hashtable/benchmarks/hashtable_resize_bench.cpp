@@ -0,0 +1,63 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "hash_funcs.hpp"
+
+/* Usage: hashtable_resize_bench [num_keys]
+ *
+ * Times every single put of num_keys distinct keys (10M by default) into
+ * an empty table, with the table doubled all at once and incrementally.
+ * Prints the total time, and the mean, median and tail latencies of a
+ * put. */
+
+using Clock = std::chrono::steady_clock;
+
+template <typename HT>
+static void run(const char* name, size_t n, bool incremental) {
+    HT ht;
+    std::vector<float> ns(n);
+    size_t sink = 0;
+
+    ht.set_incremental_resize(incremental);
+
+    auto begin = Clock::now();
+    for (size_t i = 0; i < n; i++) {
+        /* Distinct keys, spread over the int range */
+        int k = i * 2654435761u;
+
+        auto start = Clock::now();
+        sink += ht.put(k, k);
+        ns[i] = std::chrono::duration<float, std::nano>(Clock::now() - start).count();
+    }
+    double total = std::chrono::duration<double, std::milli>(Clock::now() - begin).count();
+
+    double mean = 0;
+    for (auto x : ns)
+        mean += x / n;
+    std::sort(ns.begin(), ns.end());
+
+    printf("%-24s %10.1f %9.1f %9.1f %9.1f %9.1f %12.1f\n", name, total, mean,
+           ns[n / 2], ns[n * 99 / 100], ns[n * 999 / 1000], ns[n - 1]);
+
+    /* Keep the results alive */
+    if (sink == 0 || ht.get_size() != n)
+        fputs("", stderr);
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 10'000'000;
+
+    printf("%-24s %10s %9s %9s %9s %9s %12s\n", "put", "total ms", "mean ns",
+           "p50 ns", "p99 ns", "p999 ns", "max ns");
+
+    run<LinearProbeHashTable<int, int, DefaultHash>>("linear", n, false);
+    run<LinearProbeHashTable<int, int, DefaultHash>>("linear incremental", n, true);
+    run<QuadProbeHashTable<int, int, DefaultHash>>("quadratic", n, false);
+    run<QuadProbeHashTable<int, int, DefaultHash>>("quadratic incremental", n, true);
+
+    return 0;
+}
@@ -0,0 +1,130 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "hash_funcs.hpp"
+#include "robin_hood_table.hpp"
+
+/* Usage: robin_hood_bench [num_keys] [churn_rounds]
+ *
+ * Fills each table with num_keys random keys (20k by default), then runs
+ * churn_rounds rounds (3 by default) of num_keys operations each, every
+ * one removing a random live key and inserting a new one. After the fill
+ * and after each round, prints the histogram of probe lengths over all the
+ * live keys, as returned by get(), with their mean, standard deviation and
+ * maximum, and times lookups of absent keys.
+ *
+ * HashTable leaves a tombstone behind every removal and only reuses empty
+ * slots, so a put can fail once there are none left. Failed puts are
+ * counted. */
+
+using Clock = std::chrono::steady_clock;
+
+/* Probe lengths 0, 1, 2, 3, 4-7, 8-15, ... */
+static constexpr size_t NUM_BUCKETS = 10;
+
+static size_t bucket(int probes) {
+    size_t b = 0;
+    while (b + 1 < NUM_BUCKETS && probes >= (b < 4 ? (int)b + 1 : 1 << (b - 1)))
+        b++;
+    return b;
+}
+
+static const char* bucket_names[NUM_BUCKETS] = {
+    "0", "1", "2", "3", "4-7", "8-15", "16-31", "32-63", "64-127", "128+",
+};
+
+template <typename HT>
+static void report(const char* name, HT& ht, const std::vector<int>& live,
+                   const std::vector<int>& misses, size_t failed) {
+    size_t hist[NUM_BUCKETS] = {};
+    double sum = 0, sum_sq = 0;
+    int max = 0;
+    std::string value;
+
+    for (auto k : live) {
+        int probes = ht.get(k, value);
+        hist[bucket(probes)]++;
+        sum += probes;
+        sum_sq += (double)probes * probes;
+        max = std::max(max, probes);
+    }
+
+    size_t sink = 0;
+    auto start = Clock::now();
+    for (auto k : misses)
+        sink += ht.get(k, value) == -1;
+    double miss_ns = std::chrono::duration<double, std::nano>(
+        Clock::now() - start).count() / misses.size();
+
+    double mean = sum / live.size();
+    printf("  %-12s", name);
+    for (size_t b = 0; b < NUM_BUCKETS; b++)
+        printf(" %7zu", hist[b]);
+    printf(" %7.2f %7.2f %6d %9.1f %7zu\n", mean,
+           std::sqrt(sum_sq / live.size() - mean * mean), max,
+           sink == misses.size() ? miss_ns : -1.0, failed);
+}
+
+template <typename HT>
+static void run(const char* name, size_t n, size_t rounds) {
+    HT ht;
+    std::mt19937 g(0);
+    size_t failed = 0;
+
+    /* Random keys; the misses are odd, and the stored keys even */
+    auto key = [&g] { return (int)(g() & ~1u); };
+
+    std::vector<int> live, misses;
+    for (size_t i = 0; i < n; i++) {
+        live.push_back(key());
+        ht.put(live.back(), "v");
+    }
+    for (size_t i = 0; i < std::min<size_t>(n, 10000); i++)
+        misses.push_back(key() | 1);
+
+    printf("%s, load factor %.3f\n  %-12s", name, ht.get_load_factor(), "round");
+    for (auto b : bucket_names)
+        printf(" %7s", b);
+    printf(" %7s %7s %6s %9s %7s\n", "mean", "stddev", "max", "miss ns", "failed");
+
+    report("fill", ht, live, misses, failed);
+
+    std::uniform_int_distribution<size_t> pick(0, n - 1);
+    for (size_t r = 1; r <= rounds; r++) {
+        for (size_t i = 0; i < n; i++) {
+            size_t j = pick(g);
+            ht.remove(live[j]);
+            live[j] = key();
+            if (ht.put(live[j], "v") < 0) {
+                failed++;
+                live[j] = live[(j + 1) % n];
+            }
+        }
+
+        /* Keys that failed to go in, or were drawn twice, left
+           duplicates */
+        std::vector<int> distinct = live;
+        std::sort(distinct.begin(), distinct.end());
+        distinct.erase(std::unique(distinct.begin(), distinct.end()), distinct.end());
+
+        std::string round = "churn " + std::to_string(r);
+        report(round.c_str(), ht, distinct, misses, failed);
+    }
+}
+
+int main(int argc, char *argv[]) {
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 20000;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 3;
+
+    run<LinearProbeHashTable<int, std::string, DefaultHash>>("linear", n, rounds);
+    run<QuadProbeHashTable<int, std::string, DefaultHash>>("quadratic", n, rounds);
+    run<RobinHoodHashTable<int, std::string, DefaultHash>>("robin hood", n, rounds);
+
+    return 0;
+}
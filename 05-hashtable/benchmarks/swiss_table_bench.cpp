@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "hash_funcs.hpp"
+#include "swiss_table.hpp"
+
+/* Usage: swiss_table_bench [log2_slots]
+ *
+ * For target load factors from 0.5 to 0.875, fills SwissTable with that
+ * fraction of 2^log2_slots (2^20 by default) random int keys with
+ * std::string values, then times successful and failed lookups. The same
+ * keys go into LinearProbeHashTable, QuadProbeHashTable, which keep their
+ * load factor under 0.5, and std::unordered_map. Prints nanoseconds per
+ * operation, and the load factor each table ends up at. */
+
+using Clock = std::chrono::steady_clock;
+
+template<typename Func>
+static double ns_per_op(size_t n, Func&& func) {
+    auto start = Clock::now();
+    func();
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / n;
+}
+
+struct Result {
+    double insert, hit, miss, load;
+};
+
+template <typename HT>
+static Result run(const std::vector<int>& keys, const std::vector<int>& misses,
+                  size_t& sink) {
+    HT ht;
+    std::string value;
+    Result r;
+    size_t n = keys.size();
+
+    r.insert = ns_per_op(n, [&] {
+        for (auto k : keys)
+            sink += ht.put(k, std::to_string(k));
+    });
+    r.hit = ns_per_op(n, [&] {
+        for (auto k : keys)
+            sink += ht.get(k, value);
+    });
+    r.miss = ns_per_op(n, [&] {
+        for (auto k : misses)
+            sink += ht.get(k, value);
+    });
+    r.load = ht.get_load_factor();
+
+    return r;
+}
+
+/* The same interface over std::unordered_map */
+struct StdMap {
+    std::unordered_map<int, std::string, DefaultHash> map;
+
+    int put(int k, const std::string& v) { return map.emplace(k, v).second ? 0 : -1; }
+    int get(int k, std::string& v) {
+        auto it = map.find(k);
+        if (it == map.end())
+            return -1;
+        v = it->second;
+        return 0;
+    }
+    double get_load_factor() const { return map.load_factor(); }
+};
+
+static void print(const char* name, const Result& r) {
+    printf("  %-12s %8.1f %8.1f %8.1f %8.3f\n", name, r.insert, r.hit, r.miss, r.load);
+}
+
+int main(int argc, char *argv[]) {
+    size_t log2_slots = argc > 1 ? std::stoul(argv[1]) : 20;
+    size_t slots = size_t{1} << log2_slots;
+
+    /* Distinct random keys: the first ones are stored, the last ones missed */
+    std::mt19937 g(0);
+    std::vector<int> all(2 * slots);
+    for (size_t i = 0; i < all.size(); i++)
+        all[i] = i * 2654435761u;
+    std::shuffle(all.begin(), all.end(), g);
+
+    size_t sink = 0;
+
+    for (double load : { 0.5, 0.625, 0.75, 0.875 }) {
+        size_t n = load * slots;
+        std::vector<int> keys(all.begin(), all.begin() + n);
+        std::vector<int> misses(all.end() - n, all.end());
+
+        printf("load %.3f, %zu keys\n", load, n);
+        printf("  %-12s %8s %8s %8s %8s\n", "ns/op", "insert", "hit", "miss", "load");
+        print("swiss", run<SwissTable<int, std::string, DefaultHash>>(keys, misses, sink));
+        print("linear", run<LinearProbeHashTable<int, std::string, DefaultHash>>(keys, misses, sink));
+        print("quadratic", run<QuadProbeHashTable<int, std::string, DefaultHash>>(keys, misses, sink));
+        print("std", run<StdMap>(keys, misses, sink));
+    }
+
+    /* Keep the results alive */
+    if (sink == 0)
+        fputs("", stderr);
+
+    return 0;
+}
@@ -1,6 +1,11 @@
 #ifndef _HASH_FUNCS_HPP
 #define _HASH_FUNCS_HPP
 
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+
 struct DefaultHash {
     unsigned long operator()(const int& k) const {
         return k;
@@ -16,4 +21,148 @@ struct DefaultHash {
     }
 };
 
+/* Spread every bit of a hash over the high and the low bits, for tables
+   that take either as a position. DefaultHash leaves ints as they are. */
+static inline uint64_t mix_hash(uint64_t h) {
+    h *= 0x9e3779b97f4a7c15;
+    return h ^ (h >> 32);
+}
+
+/* DefaultHash keeps the keys' patterns: strided ints land in a few slots
+ * of a power-of-two table, and all the anagrams of a string collide. The
+ * hashers below make every bit of the key flip about half the bits of the
+ * hash, and can be passed as F to any of the tables.
+ *
+ * MurmurHash uses the 64-bit finalizer of MurmurHash3 for ints, and
+ * MurmurHash64A, 8 bytes per step, for strings. WyHash follows wyhash,
+ * which folds a 64x64 to 128-bit multiply and takes 16 bytes per step; it
+ * is the faster one on strings. */
+
+namespace hash_funcs {
+
+/* Unaligned little-endian reads */
+static inline uint64_t read64(const unsigned char* p) {
+    uint64_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t read32(const unsigned char* p) {
+    uint32_t v;
+    std::memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static inline uint64_t fmix64(uint64_t k) {
+    k ^= k >> 33;
+    k *= 0xff51afd7ed558ccd;
+    k ^= k >> 33;
+    k *= 0xc4ceb9fe1a85ec53;
+    k ^= k >> 33;
+    return k;
+}
+
+static inline uint64_t murmur64a(const unsigned char* p, size_t len,
+                                 uint64_t seed) {
+    const uint64_t m = 0xc6a4a7935bd1e995;
+    const int r = 47;
+    uint64_t h = seed ^ (len * m);
+
+    const unsigned char* end = p + (len & ~size_t{7});
+    for (; p != end; p += 8) {
+        uint64_t k = read64(p);
+        k *= m;
+        k ^= k >> r;
+        k *= m;
+        h ^= k;
+        h *= m;
+    }
+
+    /* The last len % 8 bytes */
+    if (len & 7) {
+        for (size_t i = len & 7; i > 0; i--)
+            h ^= uint64_t{p[i - 1]} << (8 * (i - 1));
+        h *= m;
+    }
+
+    h ^= h >> r;
+    h *= m;
+    h ^= h >> r;
+    return h;
+}
+
+static constexpr uint64_t WY_P0 = 0xa0761d6478bd642f;
+static constexpr uint64_t WY_P1 = 0xe7037ed1a0b428db;
+
+/* The two halves of the 128-bit product */
+static inline void wy_mum(uint64_t& a, uint64_t& b) {
+    __uint128_t r = (__uint128_t)a * b;
+    a = (uint64_t)r;
+    b = (uint64_t)(r >> 64);
+}
+
+static inline uint64_t wy_mix(uint64_t a, uint64_t b) {
+    wy_mum(a, b);
+    return a ^ b;
+}
+
+static inline uint64_t wyhash(const unsigned char* p, size_t len,
+                              uint64_t seed) {
+    uint64_t a, b;
+    seed ^= wy_mix(seed ^ WY_P0, WY_P1);
+
+    if (len <= 16) {
+        if (len >= 4) {
+            /* Two overlapping 4-byte reads from each end cover 4 to 16
+               bytes */
+            size_t mid = (len >> 3) << 2;
+            a = (read32(p) << 32) | read32(p + mid);
+            b = (read32(p + len - 4) << 32) | read32(p + len - 4 - mid);
+        } else if (len > 0) {
+            a = (uint64_t{p[0]} << 16) | (uint64_t{p[len >> 1]} << 8) | p[len - 1];
+            b = 0;
+        } else {
+            a = b = 0;
+        }
+    } else {
+        size_t i = len;
+        for (; i > 16; i -= 16, p += 16)
+            seed = wy_mix(read64(p) ^ WY_P1, read64(p + 8) ^ seed);
+
+        /* The last 16 bytes, overlapping the previous step if need be */
+        a = read64(p + i - 16);
+        b = read64(p + i - 8);
+    }
+
+    a ^= WY_P1;
+    b ^= seed;
+    wy_mum(a, b);
+    return wy_mix(a ^ WY_P0 ^ len, b ^ WY_P1);
+}
+
+} // namespace hash_funcs
+
+struct MurmurHash {
+    unsigned long operator()(const int& k) const {
+        return hash_funcs::fmix64((uint64_t)k);
+    }
+
+    unsigned long operator()(const std::string& k) const {
+        return hash_funcs::murmur64a(
+            reinterpret_cast<const unsigned char*>(k.data()), k.size(), 0);
+    }
+};
+
+struct WyHash {
+    unsigned long operator()(const int& k) const {
+        using namespace hash_funcs;
+        return wy_mix(wy_mix((uint64_t)k ^ WY_P0, WY_P1) ^ WY_P0, WY_P1);
+    }
+
+    unsigned long operator()(const std::string& k) const {
+        return hash_funcs::wyhash(
+            reinterpret_cast<const unsigned char*>(k.data()), k.size(), 0);
+    }
+};
+
 #endif
@@ -1,4 +1,5 @@
 #include <cstddef>
+#include <utility>
 
 /* Fill in the TODO sections in the following code. */
 
@@ -9,18 +10,31 @@ public:
     HashSlot(): _empty(true), _removed(false) {
     }
     
-    K get_key() const {
+    const K &get_key() const {
         return _key;
     }
 
-    V get_value() const {
+    const V &get_value() const {
         return _value;
     }
 
+    V &get_value() {
+        return _value;
+    }
+
+    // Taken by value, so that the caller copies or moves them in
     void set_key_value(K key, V value) {
 		_empty = false;
-		_key = key;
-		_value = value;
+		_removed = false;
+		_key = std::move(key);
+		_value = std::move(value);
+    }
+
+    // Move the key and value to the free slot other, and leave this one
+    // empty
+    void move_to(HashSlot &other) {
+		other.set_key_value(std::move(_key), std::move(_value));
+		_empty = true;
     }
 
     bool is_empty() const {
@@ -5,14 +5,41 @@
 #include <iterator>
 #include <memory>
 #include <cstring>
+#include <new>
+#include <utility>
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
+// A power of two, as the table only ever doubles: positions are reduced
+// with a mask
 #define INITIAL_TABLE_SIZE 64
+#define INCREMENTAL_RESIZE_STEP 16
 
 #include "hash_slot.hpp"
 
 /* Fill in the TODO sections in the following code. */
 
-template <typename K, typename V, typename F>
+/* Probing policies for HashTable. get_next_pos() returns the position of
+   probe step from that of probe step - 1, in a table of mask + 1 slots. */
+struct LinearProbe {
+    // position(k, M, i) = (hash(k) + i) % M
+    static unsigned long get_next_pos(unsigned long pos, unsigned long /*step*/,
+                                      unsigned long mask) {
+		return (pos + 1) & mask;
+    }
+};
+
+struct QuadProbe {
+    // position(k, M, i) = (hash(k) + i*(i+1)/2) % M, i past the previous
+    // probe. With M a power of two, it visits every slot.
+    static unsigned long get_next_pos(unsigned long pos, unsigned long step,
+                                      unsigned long mask) {
+		return (pos + step) & mask;
+    }
+};
+
+template <typename K, typename V, typename F, typename P>
 class HashTable {
 public:
     HashTable();
@@ -24,6 +51,35 @@ public:
     size_t get_size();
     double get_load_factor();
 
+    /* Insert key with a value constructed from args, if key is absent.
+       Unlike put(), rvalue keys and arguments are moved in, and the value
+       is only constructed if it is inserted. Returns the number of probes,
+       or -1. */
+    template <typename KK, typename... Args>
+    int emplace(KK &&key, Args &&...args);
+
+    /* Insert key and value, or assign value if key is present. Returns the
+       number of probes, or -1. */
+    template <typename KK, typename VV>
+    int insert_or_assign(KK &&key, VV &&value);
+
+    /* The value of key, or nullptr. The pointer is valid until the next
+       operation on the table. */
+    V *find(const K &key);
+
+    /* Drop the removed slots, and shrink the table as far as the load
+       factor allows */
+    void compact();
+
+    /* Keep the old table next to the new one on a resize, and move
+       INCREMENTAL_RESIZE_STEP of its slots on every operation, instead of
+       all of them at once. The doubled table is itself built ahead, a few
+       slots per put, from a load factor of 3/8 on. From there to the
+       resize at 1/2, the table takes 3 times the slots it does in
+       blocking mode; the old table is long gone by then. */
+    void set_incremental_resize(bool on);
+    bool is_resizing();
+
 protected:
     size_t table_size;
     
@@ -32,122 +88,477 @@ private:
     const HashTable & operator=(const HashTable & other);
     F hash_func;
     size_t size;
+    size_t num_removed;
     HashSlot<K, V> *table;
 
-    // Should be overriden by the derived class
-    virtual unsigned long get_next_pos(unsigned long pos,
-                                       unsigned long step) = 0;
-    unsigned long get_pos(const K key);
+    // The table being moved by an incremental resize, or nullptr
+    bool incremental;
+    HashSlot<K, V> *old_table;
+    size_t old_table_size;
+    size_t migrate_pos;
+
+    // The table the next incremental resize will double into, or nullptr.
+    // Only its first next_init slots are constructed.
+    HashSlot<K, V> *next_table;
+    size_t next_table_size;
+    size_t next_init;
+
+    unsigned long get_pos(const K &key);
+    HashSlot<K, V> *lookup(const K &key, int &step);
+    template <typename KK, typename MakeValue>
+    int insert(KK &&key, MakeValue &&make_value);
+    void relocate(HashSlot<K, V> &slot);
     void enlarge_table();
-};
+    void resize(size_t new_table_size);
+    void rehash(size_t new_table_size);
+    void migrate(size_t num_slots);
+    long find_old(const K &key, int &step);
+    void prepare();
+    void drop_next_table();
 
-template <typename K, typename V, typename F>
-class LinearProbeHashTable: public HashTable<K, V, F> {
-private:
-    virtual unsigned long get_next_pos(unsigned long pos, unsigned long step) {
-		return (pos + step) % HashTable<K, V, F>::get_table_size();
-    }
+    // Tables of at least MAPPED_TABLE_BYTES are mapped apart from the heap
+    // on Linux, so that the tables of an incremental resize can ask for
+    // huge pages without the advice outliving them
+    static constexpr size_t HUGE_PAGE_SIZE = size_t{2} << 20;
+    static constexpr size_t MAPPED_TABLE_BYTES = 2 * HUGE_PAGE_SIZE;
+
+    // Slots are constructed apart from their allocation, so that an
+    // incremental resize can spread the work over many operations
+    static HashSlot<K, V> *allocate_slots(size_t n, bool huge_pages = false);
+    static void free_slots(HashSlot<K, V> *slots, size_t n);
+    static void construct_slots(HashSlot<K, V> *slots, size_t from, size_t to);
+    static void destroy_slots(HashSlot<K, V> *slots, size_t from, size_t to);
+    static HashSlot<K, V> *new_table(size_t n, bool huge_pages = false);
+    static void delete_table(HashSlot<K, V> *slots, size_t n);
 };
 
 template <typename K, typename V, typename F>
-class QuadProbeHashTable: public HashTable<K, V, F> {
-private:
-    virtual unsigned long get_next_pos(unsigned long pos, unsigned long step) {
-		return (pos + step*(step+1)/2) % HashTable<K, V, F>::get_table_size();
-    }
-};
+class LinearProbeHashTable: public HashTable<K, V, F, LinearProbe> {};
 
 template <typename K, typename V, typename F>
-HashTable<K, V, F>::HashTable(): table(), hash_func(),
-                                 size(0), table_size(INITIAL_TABLE_SIZE) {
-    table = new HashSlot<K, V>[table_size];
+class QuadProbeHashTable: public HashTable<K, V, F, QuadProbe> {};
+
+template <typename K, typename V, typename F, typename P>
+HashTable<K, V, F, P>::HashTable(): table_size(INITIAL_TABLE_SIZE),
+                                 hash_func(), size(0), num_removed(0), table(),
+                                 incremental(false), old_table(nullptr),
+                                 old_table_size(0), migrate_pos(0),
+                                 next_table(nullptr), next_table_size(0),
+                                 next_init(0) {
+    table = new_table(table_size);
 }
 
-template <typename K, typename V, typename F>
-HashTable<K, V, F>::~HashTable() {
-	delete[] table;
+template <typename K, typename V, typename F, typename P>
+HashTable<K, V, F, P>::~HashTable() {
+	delete_table(table, table_size);
+	if(old_table)
+		delete_table(old_table, old_table_size);
+	drop_next_table();
 }
 
-template <typename K, typename V, typename F>
-void HashTable<K, V, F>::enlarge_table() {
-	table_size <<= 1;
-	size = 0;
-	HashSlot<K, V> *old_table = table;
-	table = new HashSlot<K, V>[table_size];
-	for(size_t i = 0; i < (table_size>>1); i++) {
-		if(old_table[i].is_removed() || old_table[i].is_empty()) continue;
-		put(old_table[i].get_key(), old_table[i].get_value());
+template <typename K, typename V, typename F, typename P>
+HashSlot<K, V> *HashTable<K, V, F, P>::allocate_slots(size_t n,
+                                                       bool huge_pages) {
+	size_t bytes = n * sizeof(HashSlot<K, V>);
+#ifdef __linux__
+	if(bytes >= MAPPED_TABLE_BYTES) {
+		void *slots = mmap(nullptr, bytes, PROT_READ | PROT_WRITE,
+		                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if(slots == MAP_FAILED)
+			throw std::bad_alloc();
+#ifdef MADV_HUGEPAGE
+		/* With huge pages, filling the table ahead takes a page fault
+		   every few thousand puts instead of every few dozen. Without
+		   them (EINVAL), it keeps small pages. */
+		if(huge_pages)
+			(void)madvise(slots, bytes, MADV_HUGEPAGE);
+#endif
+		return static_cast<HashSlot<K, V> *>(slots);
 	}
-	delete[] old_table;
+#endif
+	(void)huge_pages;
+	return static_cast<HashSlot<K, V> *>(::operator new(bytes));
 }
 
-template <typename K, typename V, typename F>
-unsigned long HashTable<K, V, F>::get_pos(const K key) {
-	return hash_func(key) % table_size;
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::free_slots(HashSlot<K, V> *slots, size_t n) {
+#ifdef __linux__
+	if(n * sizeof(HashSlot<K, V>) >= MAPPED_TABLE_BYTES) {
+		munmap(slots, n * sizeof(HashSlot<K, V>));
+		return;
+	}
+#endif
+	::operator delete(slots);
 }
 
-template <typename K, typename V, typename F>
-int HashTable<K, V, F>::get(const K &key, V &value) {
-	for(unsigned long i = 0; i < table_size; i++) {
-		unsigned long pos = get_next_pos(get_pos(key), i);
-		//printf("[get %d] Step %lu: pos %lu\n", key, i, pos);
-		if(table[pos].is_removed()) continue;
-		if(table[pos].is_empty()) return -1;
-		if(table[pos].get_key() == key) {
-			value = table[pos].get_value();
-			return (int)i;
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::construct_slots(HashSlot<K, V> *slots, size_t from,
+                                         size_t to) {
+	for(size_t i = from; i < to; i++)
+		new (&slots[i]) HashSlot<K, V>();
+}
+
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::destroy_slots(HashSlot<K, V> *slots, size_t from,
+                                       size_t to) {
+	for(size_t i = from; i < to; i++)
+		slots[i].~HashSlot<K, V>();
+}
+
+template <typename K, typename V, typename F, typename P>
+HashSlot<K, V> *HashTable<K, V, F, P>::new_table(size_t n, bool huge_pages) {
+	HashSlot<K, V> *slots = allocate_slots(n, huge_pages);
+	construct_slots(slots, 0, n);
+	return slots;
+}
+
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::delete_table(HashSlot<K, V> *slots, size_t n) {
+	destroy_slots(slots, 0, n);
+	free_slots(slots, n);
+}
+
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::enlarge_table() {
+	resize(table_size << 1);
+}
+
+/* Switch to a fresh table of new_table_size slots, which must be a power
+   of two no smaller than the current size. An incremental resize leaves
+   the live slots in the old table, for migrate() to move. */
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::resize(size_t new_table_size) {
+	if(!incremental) {
+		rehash(new_table_size);
+		return;
+	}
+
+	/* Finish the previous resize. The migration moves several slots per
+	   put, so it is normally long done by the time the next one starts. */
+	migrate(old_table_size);
+
+	old_table = table;
+	old_table_size = table_size;
+	migrate_pos = 0;
+
+	/* Take the table built by prepare() if it has the right size. A
+	   same-size rehash, to drop removed slots, still builds its table
+	   here. */
+	if(next_table && next_table_size == new_table_size) {
+		construct_slots(next_table, next_init, next_table_size);
+		table = next_table;
+		next_table = nullptr;
+	} else {
+		drop_next_table();
+		table = new_table(new_table_size, true);
+	}
+
+	table_size = new_table_size;
+	num_removed = 0;
+}
+
+/* Re-insert every live slot into a fresh table, which drops the removed
+   ones */
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::rehash(size_t new_table_size) {
+	migrate(old_table_size);
+	drop_next_table();
+
+	size_t prev_table_size = table_size;
+	HashSlot<K, V> *prev_table = table;
+
+	table_size = new_table_size;
+	num_removed = 0;
+	table = new_table(table_size);
+	for(size_t i = 0; i < prev_table_size; i++) {
+		if(prev_table[i].is_removed() || prev_table[i].is_empty()) continue;
+		relocate(prev_table[i]);
+	}
+	delete_table(prev_table, prev_table_size);
+}
+
+/* Move the next num_slots slots of the old table to the new one. A moved
+   slot is left removed, not empty: the keys further along its cluster are
+   still looked up through it. */
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::migrate(size_t num_slots) {
+	if(!old_table)
+		return;
+
+	size_t end = std::min(old_table_size, migrate_pos + num_slots);
+	for(; migrate_pos < end; migrate_pos++) {
+		HashSlot<K, V> &slot = old_table[migrate_pos];
+		if(slot.is_removed() || slot.is_empty())
+			continue;
+
+		/* put() looks for duplicates in the old table first, so the key
+		   is not in the new one */
+		relocate(slot);
+		slot.set_removed();
+	}
+
+	if(migrate_pos == old_table_size) {
+		delete_table(old_table, old_table_size);
+		old_table = nullptr;
+	}
+}
+
+/* Move a live slot into the first free slot of its probe path in table,
+   where its key must not be */
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::relocate(HashSlot<K, V> &slot) {
+	unsigned long mask = table_size - 1;
+	unsigned long pos = get_pos(slot.get_key());
+	for(unsigned long i = 0; i < table_size; pos = P::get_next_pos(pos, ++i, mask)) {
+		if(table[pos].is_removed() || table[pos].is_empty()) {
+			if(table[pos].is_removed())
+				num_removed--;
+			slot.move_to(table[pos]);
+			return;
+		}
+	}
+}
+
+/* Construct the next slots of the table the next resize will double
+   into. It is allocated once the load factor reaches 3/8, which leaves at
+   least table_size / 8 puts before the resize at 1/2 to build its
+   2 * table_size slots: 16 per put, or as many as the puts left take. A
+   migration, INCREMENTAL_RESIZE_STEP slots per operation, is over by
+   then. */
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::prepare() {
+	if(!incremental || size * 8 < table_size * 3)
+		return;
+
+	if(next_table && next_table_size != table_size << 1)
+		drop_next_table();
+	if(!next_table) {
+		next_table_size = table_size << 1;
+		next_table = allocate_slots(next_table_size, true);
+		next_init = 0;
+	}
+
+	size_t puts_left = size < table_size / 2 ? table_size / 2 - size : 1;
+	size_t num_slots = (next_table_size - next_init + puts_left - 1) / puts_left;
+	size_t end = std::min(next_table_size, next_init + num_slots);
+	construct_slots(next_table, next_init, end);
+	next_init = end;
+}
+
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::drop_next_table() {
+	if(!next_table)
+		return;
+	destroy_slots(next_table, 0, next_init);
+	free_slots(next_table, next_table_size);
+	next_table = nullptr;
+}
+
+template <typename K, typename V, typename F, typename P>
+long HashTable<K, V, F, P>::find_old(const K &key, int &step) {
+	if(!old_table)
+		return -1;
+
+	unsigned long mask = old_table_size - 1;
+	unsigned long pos = hash_func(key) & mask;
+	for(unsigned long i = 0; i < old_table_size; pos = P::get_next_pos(pos, ++i, mask)) {
+		if(old_table[pos].is_removed()) continue;
+		if(old_table[pos].is_empty()) return -1;
+		if(old_table[pos].get_key() == key) {
+			step = (int)i;
+			return (long)pos;
 		}
 	}
 	return -1;
 }
 
-template <typename K, typename V, typename F>
-int HashTable<K, V, F>::put(const K &key, const V &value) {
-	for(unsigned long i = 0; i < table_size; i++) {
-		unsigned long pos = get_next_pos(get_pos(key), i);
-		//printf("[put %d] Step %lu: pos %lu\n", key, i, pos);
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::compact() {
+	size_t new_table_size = INITIAL_TABLE_SIZE;
+	while((double)size / new_table_size >= 0.5)
+		new_table_size <<= 1;
+	rehash(new_table_size);
+}
+
+template <typename K, typename V, typename F, typename P>
+void HashTable<K, V, F, P>::set_incremental_resize(bool on) {
+	if(!on) {
+		migrate(old_table_size);
+		drop_next_table();
+	}
+	incremental = on;
+}
+
+template <typename K, typename V, typename F, typename P>
+bool HashTable<K, V, F, P>::is_resizing() {
+	return old_table != nullptr;
+}
+
+template <typename K, typename V, typename F, typename P>
+unsigned long HashTable<K, V, F, P>::get_pos(const K &key) {
+	return hash_func(key) & (table_size - 1);
+}
+
+/* The slot of key, in the table or else in the old one, or nullptr */
+template <typename K, typename V, typename F, typename P>
+HashSlot<K, V> *HashTable<K, V, F, P>::lookup(const K &key, int &step) {
+	unsigned long mask = table_size - 1;
+	unsigned long pos = get_pos(key);
+	for(unsigned long i = 0; i < table_size; pos = P::get_next_pos(pos, ++i, mask)) {
 		if(table[pos].is_removed()) continue;
+		if(table[pos].is_empty()) break;
+		if(table[pos].get_key() == key) {
+			step = (int)i;
+			return &table[pos];
+		}
+	}
+
+	long old_pos = find_old(key, step);
+	if(old_pos < 0)
+		return nullptr;
+	return &old_table[old_pos];
+}
+
+template <typename K, typename V, typename F, typename P>
+int HashTable<K, V, F, P>::get(const K &key, V &value) {
+	migrate(INCREMENTAL_RESIZE_STEP);
+
+	int step;
+	HashSlot<K, V> *slot = lookup(key, step);
+	if(!slot)
+		return -1;
+	value = slot->get_value();
+	return step;
+}
+
+template <typename K, typename V, typename F, typename P>
+V *HashTable<K, V, F, P>::find(const K &key) {
+	migrate(INCREMENTAL_RESIZE_STEP);
+
+	int step;
+	HashSlot<K, V> *slot = lookup(key, step);
+	return slot ? &slot->get_value() : nullptr;
+}
+
+/* The key goes into the first removed slot on its probe path, if any, but
+   the search for a duplicate goes on to the first empty slot. Once live
+   and removed slots take 3/4 of the table, it is rehashed at the same
+   size, so that searches keep finding empty slots.
+
+   make_value() gives the value to store, and is only called once the key
+   is known to be absent. */
+template <typename K, typename V, typename F, typename P>
+template <typename KK, typename MakeValue>
+int HashTable<K, V, F, P>::insert(KK &&key, MakeValue &&make_value) {
+	migrate(INCREMENTAL_RESIZE_STEP);
+	prepare();
+
+	int old_step;
+	if(find_old(key, old_step) >= 0)
+		return -1;
+
+	unsigned long mask = table_size - 1;
+	unsigned long pos = get_pos(key);
+	unsigned long reuse_pos = 0, reuse_step = table_size;
+
+	for(unsigned long i = 0; i < table_size; pos = P::get_next_pos(pos, ++i, mask)) {
+		if(table[pos].is_removed()) {
+			if(reuse_step == table_size) {
+				reuse_pos = pos;
+				reuse_step = i;
+			}
+			continue;
+		}
 		if(table[pos].is_empty()) {
-			table[pos].set_key_value(key, value);
-			//printf("[put %d] table[%lu] = %d\n", key, pos, value);
+			if(reuse_step < table_size)
+				break;
+			table[pos].set_key_value(std::forward<KK>(key), make_value());
 			size++;
 			if(get_load_factor() >= 0.5)
 				enlarge_table();
+			else if(!old_table && (size + num_removed) * 4 >= table_size * 3)
+				resize(table_size);
 			return (int)i;
 		} else if(table[pos].get_key() == key) {
 			return -1;
 		}
 	}
-	return -1;
+
+	if(reuse_step == table_size)
+		return -1;
+
+	table[reuse_pos].set_key_value(std::forward<KK>(key), make_value());
+	num_removed--;
+	size++;
+	if(get_load_factor() >= 0.5)
+		enlarge_table();
+	return (int)reuse_step;
 }
 
-template <typename K, typename V, typename F>
-int HashTable<K, V, F>::remove(const K &key) {
-	for(unsigned long i = 0; i < table_size; i++) {
-		unsigned long pos = get_next_pos(get_pos(key), i);
-		//printf("[remove %d] Step %lu: pos %lu\n", key, i, pos);
+template <typename K, typename V, typename F, typename P>
+int HashTable<K, V, F, P>::put(const K &key, const V &value) {
+	return insert(key, [&value]() -> const V & { return value; });
+}
+
+template <typename K, typename V, typename F, typename P>
+template <typename KK, typename... Args>
+int HashTable<K, V, F, P>::emplace(KK &&key, Args &&...args) {
+	return insert(std::forward<KK>(key),
+	              [&] { return V(std::forward<Args>(args)...); });
+}
+
+template <typename K, typename V, typename F, typename P>
+template <typename KK, typename VV>
+int HashTable<K, V, F, P>::insert_or_assign(KK &&key, VV &&value) {
+	migrate(INCREMENTAL_RESIZE_STEP);
+
+	int step;
+	if(HashSlot<K, V> *slot = lookup(key, step)) {
+		slot->get_value() = std::forward<VV>(value);
+		return step;
+	}
+	return insert(std::forward<KK>(key),
+	              [&value]() -> VV && { return std::forward<VV>(value); });
+}
+
+template <typename K, typename V, typename F, typename P>
+int HashTable<K, V, F, P>::remove(const K &key) {
+	migrate(INCREMENTAL_RESIZE_STEP);
+
+	unsigned long mask = table_size - 1;
+	unsigned long pos = get_pos(key);
+	for(unsigned long i = 0; i < table_size; pos = P::get_next_pos(pos, ++i, mask)) {
 		if(table[pos].is_removed()) continue;
-		else if(table[pos].is_empty()) return -1;
+		else if(table[pos].is_empty()) break;
 		else if(table[pos].get_key() == key) {
 			table[pos].set_removed();
+			num_removed++;
 			size--;
 			return (int)i;
 		}
 	}
-	return -1;
+
+	/* The old table is dropped once migrated, removed slots and all */
+	int step;
+	long old_pos = find_old(key, step);
+	if(old_pos < 0)
+		return -1;
+	old_table[old_pos].set_removed();
+	size--;
+	return step;
 }
 
-template <typename K, typename V, typename F>
-size_t HashTable<K, V, F>::get_table_size() {
+template <typename K, typename V, typename F, typename P>
+size_t HashTable<K, V, F, P>::get_table_size() {
     return table_size;
 }
 
-template <typename K, typename V, typename F>
-size_t HashTable<K, V, F>::get_size() {
+template <typename K, typename V, typename F, typename P>
+size_t HashTable<K, V, F, P>::get_size() {
     return size;
 }
 
-template <typename K, typename V, typename F>
-double HashTable<K, V, F>::get_load_factor() {
+template <typename K, typename V, typename F, typename P>
+double HashTable<K, V, F, P>::get_load_factor() {
     return (double)size/table_size;
 }
@@ -0,0 +1,194 @@
+#ifndef _ROBIN_HOOD_TABLE_HPP
+#define _ROBIN_HOOD_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "hash_funcs.hpp"
+
+/* A linear-probing hash table with Robin Hood insertion and backward-shift
+ * deletion.
+ *
+ * Every slot records its distance from its key's home slot. An insertion
+ * that meets a key closer to its home than the new key is to its own takes
+ * that slot, and carries the displaced key further. The probe lengths thus
+ * stay close to their mean instead of growing long tails, and a search
+ * stops as soon as it meets a key closer to home than the one searched.
+ *
+ * A removal shifts the following keys of the cluster back by one slot,
+ * until an empty slot or a key already at home. There are no tombstones,
+ * so churn does not lengthen the probes.
+ *
+ * The table grows at a load factor of 7/8. The interface and the number of
+ * probes are the same as HashTable's. */
+
+template <typename K, typename V>
+struct RobinHoodSlot {
+    static constexpr int32_t EMPTY = -1;
+
+    K key;
+    V value;
+    int32_t dist = EMPTY;   /* From the home slot */
+
+    bool is_empty() const { return dist == EMPTY; }
+};
+
+template <typename K, typename V, typename F>
+class RobinHoodHashTable {
+public:
+    RobinHoodHashTable();
+    ~RobinHoodHashTable();
+    int get(const K &key, V &value) const;
+    int put(const K &key, const V &value);
+    int remove(const K &key);
+    size_t get_table_size() const { return table_size; }
+    size_t get_size() const { return size; }
+    double get_load_factor() const { return (double)size / table_size; }
+
+    static constexpr size_t INITIAL_SIZE = 64;
+
+private:
+    RobinHoodHashTable(const RobinHoodHashTable &other);
+    const RobinHoodHashTable & operator=(const RobinHoodHashTable &other);
+
+    F hash_func;
+    size_t size;
+    size_t table_size;
+    RobinHoodSlot<K, V> *table;
+
+    size_t get_pos(const K &key) const {
+        return mix_hash(hash_func(key)) & (table_size - 1);
+    }
+
+    /* The slot of key, or -1 */
+    long find(const K &key) const;
+    /* Place a key known to be absent, and return its distance */
+    int insert(K key, V value);
+    void enlarge_table();
+};
+
+template <typename K, typename V, typename F>
+RobinHoodHashTable<K, V, F>::RobinHoodHashTable(): hash_func(), size(0),
+                                                   table_size(INITIAL_SIZE) {
+    table = new RobinHoodSlot<K, V>[table_size];
+}
+
+template <typename K, typename V, typename F>
+RobinHoodHashTable<K, V, F>::~RobinHoodHashTable() {
+    delete[] table;
+}
+
+template <typename K, typename V, typename F>
+long RobinHoodHashTable<K, V, F>::find(const K &key) const {
+    size_t mask = table_size - 1;
+    size_t pos = get_pos(key);
+
+    /* Had key been any further, it would have taken this slot */
+    for (int32_t d = 0; table[pos].dist >= d; d++) {
+        if (table[pos].key == key)
+            return (long)pos;
+        pos = (pos + 1) & mask;
+    }
+
+    return -1;
+}
+
+template <typename K, typename V, typename F>
+int RobinHoodHashTable<K, V, F>::insert(K key, V value) {
+    size_t mask = table_size - 1;
+    size_t pos = get_pos(key);
+    int32_t d = 0;
+    int placed = -1;
+
+    for (;;) {
+        RobinHoodSlot<K, V> &slot = table[pos];
+
+        if (slot.is_empty()) {
+            slot.key = std::move(key);
+            slot.value = std::move(value);
+            slot.dist = d;
+            return placed < 0 ? d : placed;
+        }
+
+        /* Take from the rich: the key closer to its home moves on */
+        if (slot.dist < d) {
+            std::swap(slot.key, key);
+            std::swap(slot.value, value);
+            std::swap(slot.dist, d);
+            if (placed < 0)
+                placed = slot.dist;
+        }
+
+        pos = (pos + 1) & mask;
+        d++;
+    }
+}
+
+template <typename K, typename V, typename F>
+int RobinHoodHashTable<K, V, F>::get(const K &key, V &value) const {
+    long pos = find(key);
+    if (pos < 0)
+        return -1;
+
+    value = table[pos].value;
+    return table[pos].dist;
+}
+
+template <typename K, typename V, typename F>
+int RobinHoodHashTable<K, V, F>::put(const K &key, const V &value) {
+    if (find(key) >= 0)
+        return -1;
+
+    if ((size + 1) * 8 > table_size * 7)
+        enlarge_table();
+
+    size++;
+    return insert(key, value);
+}
+
+template <typename K, typename V, typename F>
+int RobinHoodHashTable<K, V, F>::remove(const K &key) {
+    long found = find(key);
+    if (found < 0)
+        return -1;
+
+    size_t mask = table_size - 1;
+    size_t pos = found;
+    int probes = table[pos].dist;
+
+    /* Shift the rest of the cluster back, up to an empty slot or a key at
+       its home */
+    for (size_t next = (pos + 1) & mask;
+         table[next].dist > 0;
+         pos = next, next = (next + 1) & mask) {
+        table[pos].key = std::move(table[next].key);
+        table[pos].value = std::move(table[next].value);
+        table[pos].dist = table[next].dist - 1;
+    }
+
+    table[pos].key = K();
+    table[pos].value = V();
+    table[pos].dist = RobinHoodSlot<K, V>::EMPTY;
+    size--;
+
+    return probes;
+}
+
+template <typename K, typename V, typename F>
+void RobinHoodHashTable<K, V, F>::enlarge_table() {
+    RobinHoodSlot<K, V> *old_table = table;
+    size_t old_size = table_size;
+
+    table_size <<= 1;
+    table = new RobinHoodSlot<K, V>[table_size];
+
+    for (size_t i = 0; i < old_size; i++)
+        if (!old_table[i].is_empty())
+            insert(std::move(old_table[i].key), std::move(old_table[i].value));
+
+    delete[] old_table;
+}
+
+#endif
@@ -0,0 +1,285 @@
+#ifndef _SWISS_TABLE_HPP
+#define _SWISS_TABLE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+
+#if defined(__SSE2__) && !defined(SWISS_TABLE_PORTABLE)
+#include <emmintrin.h>
+#define SWISS_TABLE_SSE2
+#endif
+
+#include "hash_funcs.hpp"
+
+/* An open-addressing hash table in the style of Abseil's Swiss tables.
+ *
+ * The slots are split in three parallel arrays: one control byte per slot,
+ * then the keys, then the values. A control byte is EMPTY, DELETED, or,
+ * for a full slot, the low 7 bits of the key's hash (H2). The remaining
+ * bits (H1) pick the home group of 16 slots.
+ *
+ * A lookup loads the 16 control bytes of a group at once, and compares
+ * them with H2 in a few SSE2 instructions. Only the slots that match, one
+ * in 128 on average for a wrong key, have their keys read, and the values
+ * are only touched on a hit. The groups are probed in triangular order,
+ * which visits every group when there are a power of two of them. A group
+ * with an EMPTY slot ends the search. The hash goes through mix_hash(), as
+ * both its high and its low bits are used.
+ *
+ * The table grows at a load factor of 7/8, counting DELETED slots. The
+ * interface is the same as HashTable's, except that the number of probes
+ * counts groups rather than slots. */
+
+enum : int8_t {
+    SWISS_EMPTY = -128,     /* 0b10000000 */
+    SWISS_DELETED = -2,     /* 0b11111110 */
+    /* Full slots are 0b0xxxxxxx */
+};
+
+/* The control bytes of a group, and the slots matching a condition as a
+   bit mask, lowest slot in the lowest bit */
+struct SwissGroup {
+    static constexpr size_t SIZE = 16;
+
+    const int8_t* ctrl;
+
+#ifdef SWISS_TABLE_SSE2
+    __m128i load() const {
+        return _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+    }
+
+    uint32_t match(int8_t h2) const {
+        return _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_set1_epi8(h2), load()));
+    }
+
+    uint32_t match_empty() const {
+        return match(SWISS_EMPTY);
+    }
+
+    /* EMPTY and DELETED are the only negative control bytes */
+    uint32_t match_empty_or_deleted() const {
+        return _mm_movemask_epi8(load());
+    }
+#else
+    uint32_t match(int8_t h2) const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < SIZE; i++)
+            mask |= uint32_t{ ctrl[i] == h2 } << i;
+        return mask;
+    }
+
+    uint32_t match_empty() const {
+        return match(SWISS_EMPTY);
+    }
+
+    uint32_t match_empty_or_deleted() const {
+        uint32_t mask = 0;
+        for (size_t i = 0; i < SIZE; i++)
+            mask |= uint32_t{ ctrl[i] < 0 } << i;
+        return mask;
+    }
+#endif
+};
+
+template <typename K, typename V, typename F>
+class SwissTable {
+public:
+    SwissTable();
+    ~SwissTable();
+    int get(const K &key, V &value) const;
+    int put(const K &key, const V &value);
+    int remove(const K &key);
+    size_t get_table_size() const { return table_size; }
+    size_t get_size() const { return size; }
+    double get_load_factor() const { return (double)size / table_size; }
+
+    static constexpr size_t INITIAL_SIZE = 4 * SwissGroup::SIZE;
+
+private:
+    SwissTable(const SwissTable &other);
+    const SwissTable & operator=(const SwissTable &other);
+
+    F hash_func;
+    size_t size;
+    size_t num_deleted;
+    size_t table_size;
+    int8_t *ctrl;
+    K *keys;
+    V *values;
+
+    uint64_t get_hash(const K &key) const { return mix_hash(hash_func(key)); }
+
+    static int8_t h2(uint64_t h) { return h & 0x7f; }
+
+    size_t num_groups() const { return table_size / SwissGroup::SIZE; }
+    size_t home_group(uint64_t h) const { return (h >> 7) & (num_groups() - 1); }
+
+    /* The slot of key, or -1. probes is the number of groups after the
+       first that were searched. */
+    long find(const K &key, uint64_t h, int &probes) const;
+    /* The first EMPTY or DELETED slot on the probe sequence of h */
+    size_t find_non_full(uint64_t h, int &probes) const;
+
+    void allocate(size_t n);
+    void rehash(size_t new_size);
+};
+
+template <typename K, typename V, typename F>
+SwissTable<K, V, F>::SwissTable(): hash_func(), size(0), num_deleted(0) {
+    allocate(INITIAL_SIZE);
+}
+
+template <typename K, typename V, typename F>
+SwissTable<K, V, F>::~SwissTable() {
+    delete[] ctrl;
+    delete[] keys;
+    delete[] values;
+}
+
+template <typename K, typename V, typename F>
+void SwissTable<K, V, F>::allocate(size_t n) {
+    table_size = n;
+    ctrl = new int8_t[n];
+    keys = new K[n];
+    values = new V[n];
+    std::memset(ctrl, SWISS_EMPTY, n);
+}
+
+template <typename K, typename V, typename F>
+long SwissTable<K, V, F>::find(const K &key, uint64_t h, int &probes) const {
+    size_t mask = num_groups() - 1;
+    size_t g = home_group(h);
+
+    for (size_t i = 0; i <= mask; i++) {
+        SwissGroup group{ ctrl + g * SwissGroup::SIZE };
+        probes = (int)i;
+
+        for (uint32_t m = group.match(h2(h)); m; m &= m - 1) {
+            size_t pos = g * SwissGroup::SIZE + __builtin_ctz(m);
+            if (keys[pos] == key)
+                return (long)pos;
+        }
+
+        if (group.match_empty())
+            return -1;
+
+        g = (g + i + 1) & mask;
+    }
+
+    return -1;
+}
+
+template <typename K, typename V, typename F>
+size_t SwissTable<K, V, F>::find_non_full(uint64_t h, int &probes) const {
+    size_t mask = num_groups() - 1;
+    size_t g = home_group(h);
+
+    /* The load factor limit keeps an EMPTY slot somewhere */
+    for (size_t i = 0; ; i++) {
+        uint32_t m = SwissGroup{ ctrl + g * SwissGroup::SIZE }.match_empty_or_deleted();
+        if (m) {
+            probes = (int)i;
+            return g * SwissGroup::SIZE + __builtin_ctz(m);
+        }
+        g = (g + i + 1) & mask;
+    }
+}
+
+template <typename K, typename V, typename F>
+int SwissTable<K, V, F>::get(const K &key, V &value) const {
+    int probes;
+    long pos = find(key, get_hash(key), probes);
+    if (pos < 0)
+        return -1;
+
+    value = values[pos];
+    return probes;
+}
+
+template <typename K, typename V, typename F>
+int SwissTable<K, V, F>::put(const K &key, const V &value) {
+    uint64_t h = get_hash(key);
+    int probes;
+
+    if (find(key, h, probes) >= 0)
+        return -1;
+
+    size_t pos = find_non_full(h, probes);
+
+    /* Filling an EMPTY slot takes the table closer to a full probe cycle,
+       reusing a DELETED one does not */
+    if (ctrl[pos] == SWISS_EMPTY &&
+        (size + num_deleted + 1) * 8 > table_size * 7) {
+        /* Drop the tombstones in place if that frees enough room */
+        rehash((size + 1) * 16 > table_size * 7 ? table_size * 2 : table_size);
+        pos = find_non_full(h, probes);
+    }
+
+    if (ctrl[pos] == SWISS_DELETED)
+        num_deleted--;
+
+    ctrl[pos] = h2(h);
+    keys[pos] = key;
+    values[pos] = value;
+    size++;
+
+    return probes;
+}
+
+template <typename K, typename V, typename F>
+int SwissTable<K, V, F>::remove(const K &key) {
+    int probes;
+    long pos = find(key, get_hash(key), probes);
+    if (pos < 0)
+        return -1;
+
+    /* A search only goes past a group with no EMPTY slot. If this group
+       has one, no search ever went past it, and the slot can be EMPTY
+       again. */
+    size_t g = pos / SwissGroup::SIZE;
+    if (SwissGroup{ ctrl + g * SwissGroup::SIZE }.match_empty()) {
+        ctrl[pos] = SWISS_EMPTY;
+    } else {
+        ctrl[pos] = SWISS_DELETED;
+        num_deleted++;
+    }
+
+    keys[pos] = K();
+    values[pos] = V();
+    size--;
+
+    return probes;
+}
+
+template <typename K, typename V, typename F>
+void SwissTable<K, V, F>::rehash(size_t new_size) {
+    int8_t *old_ctrl = ctrl;
+    K *old_keys = keys;
+    V *old_values = values;
+    size_t old_size = table_size;
+
+    allocate(new_size);
+    num_deleted = 0;
+
+    /* The keys are known to be distinct, so there is no need to search */
+    for (size_t i = 0; i < old_size; i++) {
+        if (old_ctrl[i] < 0)
+            continue;
+
+        uint64_t h = get_hash(old_keys[i]);
+        int probes;
+        size_t pos = find_non_full(h, probes);
+        ctrl[pos] = h2(h);
+        keys[pos] = std::move(old_keys[i]);
+        values[pos] = std::move(old_values[i]);
+    }
+
+    delete[] old_ctrl;
+    delete[] old_keys;
+    delete[] old_values;
+}
+
+#endif
@@ -0,0 +1,191 @@
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "hash_table.hpp"
+#include "hash_funcs.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+/* A few of the SMHasher checks, at sizes that run in a second */
+
+/* Flip each bit of random keys, and require every bit of the hash to flip
+   with probability close to 1/2 */
+template <typename F, typename K, typename Flip>
+static void check_avalanche(size_t key_bits, Flip flip, K (*random_key)(std::mt19937&)) {
+    const size_t samples = 4000;
+    F hash_func;
+    std::mt19937 g(0);
+    std::vector<size_t> flips(key_bits * 64);
+
+    for (size_t s = 0; s < samples; s++) {
+        K key = random_key(g);
+        uint64_t h = hash_func(key);
+        for (size_t i = 0; i < key_bits; i++) {
+            K flipped = flip(key, i);
+            uint64_t d = h ^ (uint64_t)hash_func(flipped);
+            for (size_t j = 0; j < 64; j++)
+                flips[i * 64 + j] += (d >> j) & 1;
+        }
+    }
+
+    /* The standard deviation of each ratio is 0.008 */
+    double worst = 0;
+    for (auto f : flips)
+        worst = std::max(worst, std::fabs((double)f / samples - 0.5));
+    INFO("worst bias " << worst);
+    REQUIRE(worst < 0.05);
+}
+
+static int random_int(std::mt19937& g) {
+    return (int)g();
+}
+
+static std::string random_string(std::mt19937& g) {
+    std::string s(24, '\0');
+    for (auto& c : s)
+        c = (char)g();
+    return s;
+}
+
+static int flip_int(int k, size_t i) {
+    return (int)((unsigned)k ^ (1u << i));
+}
+
+static std::string flip_string(std::string s, size_t i) {
+    s[i / 8] ^= (char)(1 << (i % 8));
+    return s;
+}
+
+/* Throw the hashes of keys into 2^12 buckets, by their low and by their
+   high bits, and require the chi-square statistic to be within 5 standard
+   deviations of its mean */
+template <typename F, typename K>
+static void check_distribution(const std::vector<K>& keys) {
+    const size_t log2_buckets = 12, num_buckets = size_t{1} << log2_buckets;
+    F hash_func;
+
+    for (int high = 0; high < 2; high++) {
+        std::vector<size_t> counts(num_buckets);
+        for (auto& k : keys) {
+            uint64_t h = hash_func(k);
+            counts[high ? h >> (64 - log2_buckets) : h & (num_buckets - 1)]++;
+        }
+
+        double expected = (double)keys.size() / num_buckets, chi2 = 0;
+        for (auto c : counts)
+            chi2 += (c - expected) * (c - expected) / expected;
+
+        double df = num_buckets - 1;
+        INFO((high ? "high" : "low") << " bits, chi2 " << chi2);
+        REQUIRE(std::fabs(chi2 - df) < 5 * std::sqrt(2 * df));
+    }
+}
+
+template <typename F, typename K>
+static size_t count_collisions(const std::vector<K>& keys) {
+    F hash_func;
+    std::unordered_set<uint64_t> seen;
+    for (auto& k : keys)
+        seen.insert(hash_func(k));
+    return keys.size() - seen.size();
+}
+
+static std::vector<int> sequential_ints(size_t n, int stride) {
+    std::vector<int> keys;
+    for (size_t i = 0; i < n; i++)
+        keys.push_back((int)i * stride);
+    return keys;
+}
+
+/* Ints with one or two bits set */
+static std::vector<int> sparse_ints() {
+    std::vector<int> keys;
+    for (int i = 0; i < 32; i++) {
+        keys.push_back((int)(1u << i));
+        for (int j = 0; j < i; j++)
+            keys.push_back((int)((1u << i) | (1u << j)));
+    }
+    return keys;
+}
+
+static std::vector<std::string> anagrams() {
+    std::string s = "abcdefgh";
+    std::vector<std::string> keys;
+    do {
+        keys.push_back(s);
+    } while (std::next_permutation(s.begin(), s.end()));
+    return keys;
+}
+
+static std::vector<std::string> numbered_strings(size_t n) {
+    std::vector<std::string> keys;
+    for (size_t i = 0; i < n; i++)
+        keys.push_back("key" + std::to_string(i));
+    return keys;
+}
+
+/* Every length from 0 to 64, with all-zero bytes, which only the length
+   tells apart */
+static std::vector<std::string> zero_strings() {
+    std::vector<std::string> keys;
+    for (size_t len = 0; len <= 64; len++)
+        keys.push_back(std::string(len, '\0'));
+    return keys;
+}
+
+TEMPLATE_TEST_CASE("hash avalanche", "[hash_funcs]", MurmurHash, WyHash) {
+    SECTION("int") {
+        check_avalanche<TestType>(32, flip_int, random_int);
+    }
+
+    SECTION("string") {
+        check_avalanche<TestType>(24 * 8, flip_string, random_string);
+    }
+}
+
+TEMPLATE_TEST_CASE("hash collisions", "[hash_funcs]", MurmurHash, WyHash) {
+    REQUIRE(count_collisions<TestType>(sequential_ints(1 << 20, 1)) == 0);
+    REQUIRE(count_collisions<TestType>(sparse_ints()) == 0);
+    REQUIRE(count_collisions<TestType>(anagrams()) == 0);
+    REQUIRE(count_collisions<TestType>(numbered_strings(1 << 18)) == 0);
+    REQUIRE(count_collisions<TestType>(zero_strings()) == 0);
+}
+
+TEMPLATE_TEST_CASE("hash distribution", "[hash_funcs]", MurmurHash, WyHash) {
+    const size_t n = 1 << 16;
+
+    check_distribution<TestType>(sequential_ints(n, 1));
+    check_distribution<TestType>(sequential_ints(n, 64));
+    check_distribution<TestType>(sequential_ints(n, 1 << 16));
+    check_distribution<TestType>(numbered_strings(n));
+}
+
+TEST_CASE("DefaultHash patterns", "[hash_funcs]") {
+    /* What the hashers above are for */
+    REQUIRE(count_collisions<DefaultHash>(anagrams()) == anagrams().size() - 1);
+
+    const size_t n = 1 << 12;
+    std::vector<int> strided = sequential_ints(n, 64);
+
+    auto mean_probes = [&](auto&& ht) {
+        double sum = 0;
+        for (auto k : strided)
+            sum += ht.put(k, k);
+        return sum / n;
+    };
+
+    double identity = mean_probes(LinearProbeHashTable<int, int, DefaultHash>());
+    double murmur = mean_probes(LinearProbeHashTable<int, int, MurmurHash>());
+    double wy = mean_probes(LinearProbeHashTable<int, int, WyHash>());
+
+    INFO("mean probes: identity " << identity << ", murmur " << murmur
+         << ", wy " << wy);
+    REQUIRE(murmur < 1);
+    REQUIRE(wy < 1);
+    REQUIRE(identity > 10 * murmur);
+}
@@ -1,8 +1,10 @@
 #include <algorithm>
 #include <iterator>
+#include <memory>
 #include <vector>
 #include <random>
 #include <string>
+#include <unordered_map>
 
 #include "hash_table.hpp"
 #include "hash_funcs.hpp"
@@ -175,3 +177,228 @@ TEST_CASE("hashtable probe test", "[hashtable]") {
     QuadIntStrHt quad_ht;
     probe_test<QuadIntStrHt>(quad_ht, false);
 }
+
+template <typename HT>
+void churn_test(HT &htable) {
+    int num_keys = 1000;
+    std::string value;
+
+    for (auto i=0; i<num_keys; i++)
+        REQUIRE(htable.put(i, std::to_string(i)) >= 0);
+
+    size_t table_size = htable.get_table_size();
+
+    /* Far more removals than slots: without reuse and rehashing, the
+       table would run out of empty slots */
+    for (auto i=num_keys; i<100*num_keys; i++) {
+        REQUIRE(htable.remove(i - num_keys) >= 0);
+        REQUIRE(htable.put(i, std::to_string(i)) >= 0);
+        REQUIRE(htable.get_size() == num_keys);
+    }
+    REQUIRE(htable.get_table_size() == table_size);
+
+    for (auto i=99*num_keys; i<100*num_keys; i++) {
+        REQUIRE(htable.get(i, value) >= 0);
+        REQUIRE(value == std::to_string(i));
+    }
+
+    /* A removed key is put back in its old slot */
+    REQUIRE(htable.remove(99*num_keys) >= 0);
+    int step = htable.put(99*num_keys, "again");
+    REQUIRE(step >= 0);
+    REQUIRE(htable.get(99*num_keys, value) == step);
+    REQUIRE(value == "again");
+    REQUIRE(htable.put(99*num_keys, "twice") == -1);
+
+    for (auto i=99*num_keys; i<100*num_keys - 10; i++)
+        REQUIRE(htable.remove(i) >= 0);
+
+    htable.compact();
+    REQUIRE(htable.get_table_size() == INITIAL_TABLE_SIZE);
+    REQUIRE(htable.get_size() == 10);
+    for (auto i=100*num_keys - 10; i<100*num_keys; i++) {
+        REQUIRE(htable.get(i, value) >= 0);
+        REQUIRE(value == std::to_string(i));
+    }
+}
+
+TEST_CASE("hashtable churn", "[hashtable]") {
+    LinearIntStrHt linear_ht;
+    churn_test<LinearIntStrHt>(linear_ht);
+
+    QuadIntStrHt quad_ht;
+    churn_test<QuadIntStrHt>(quad_ht);
+}
+
+template <typename HT>
+void incremental_resize_test(HT &htable) {
+    int num_to_test = 10000;
+    std::string value;
+    bool resized = false;
+
+    htable.set_incremental_resize(true);
+
+    for (auto i=0; i<num_to_test; i++) {
+        REQUIRE(htable.put(i, std::to_string(i)) >= 0);
+        REQUIRE(htable.get_load_factor() <= 0.5);
+        resized |= htable.is_resizing();
+
+        /* Keys are found, and not put twice, wherever they are */
+        if (htable.is_resizing()) {
+            REQUIRE(htable.put(i / 2, "dup") == -1);
+            REQUIRE(htable.get(i / 2, value) >= 0);
+            REQUIRE(value == std::to_string(i / 2));
+        }
+    }
+    REQUIRE(resized);
+    REQUIRE(htable.get_size() == num_to_test);
+
+    /* Removals in the middle of a resize */
+    for (auto i=num_to_test; !htable.is_resizing(); i++)
+        REQUIRE(htable.put(i, std::to_string(i)) >= 0);
+    for (auto i=0; i<num_to_test; i+=2)
+        REQUIRE(htable.remove(i) >= 0);
+    REQUIRE(!htable.is_resizing());
+
+    for (auto i=0; i<num_to_test; i++) {
+        REQUIRE((htable.get(i, value) >= 0) == (i % 2 == 1));
+        REQUIRE((htable.remove(i) >= 0) == (i % 2 == 1));
+    }
+}
+
+TEST_CASE("hashtable incremental resize", "[hashtable]") {
+    LinearIntStrHt linear_ht;
+    incremental_resize_test<LinearIntStrHt>(linear_ht);
+
+    QuadIntStrHt quad_ht;
+    incremental_resize_test<QuadIntStrHt>(quad_ht);
+}
+
+/* Eight keys to a hash, so that clusters run across the slots a resize
+   has already moved */
+struct ClusterHash {
+    unsigned long operator()(const int& k) const {
+        return (unsigned long)k / 8;
+    }
+};
+
+template <typename HT>
+void colliding_resize_test(HT &htable) {
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> keys(0, 1 << 14), ops(0, 3);
+    std::unordered_map<int, std::string> model;
+    std::string value;
+    size_t resizing = 0;
+
+    htable.set_incremental_resize(true);
+
+    for (int i = 0; i < 200000; i++) {
+        int k = keys(g);
+        bool present = model.count(k);
+
+        switch (ops(g)) {
+        case 0:
+        case 1:
+            REQUIRE((htable.put(k, std::to_string(i)) >= 0) == !present);
+            model.emplace(k, std::to_string(i));
+            break;
+        case 2:
+            REQUIRE((htable.get(k, value) >= 0) == present);
+            if (present)
+                REQUIRE(value == model[k]);
+            break;
+        case 3:
+            REQUIRE((htable.remove(k) >= 0) == present);
+            model.erase(k);
+            break;
+        }
+        REQUIRE(htable.get_size() == model.size());
+        resizing += htable.is_resizing();
+    }
+    REQUIRE(resizing > 0);
+
+    for (auto& [k, v] : model) {
+        REQUIRE(htable.get(k, value) >= 0);
+        REQUIRE(value == v);
+    }
+}
+
+TEST_CASE("hashtable incremental resize with collisions", "[hashtable]") {
+    LinearProbeHashTable<int, std::string, ClusterHash> linear_ht;
+    colliding_resize_test(linear_ht);
+
+    QuadProbeHashTable<int, std::string, ClusterHash> quad_ht;
+    colliding_resize_test(quad_ht);
+}
+
+template <typename HT>
+void move_test(HT &htable) {
+    /* Long enough not to be stored inline */
+    std::string key = "a key that does not fit inline", value(40, 'v');
+    std::string taken_key = key, taken_value = value;
+
+    REQUIRE(htable.find(key) == nullptr);
+    REQUIRE(htable.emplace(std::move(taken_key), std::move(taken_value)) >= 0);
+    REQUIRE(htable.find(key) != nullptr);
+    REQUIRE(*htable.find(key) == value);
+
+    /* The value is not constructed, so not moved from, when key is present */
+    std::string other(40, 'o');
+    REQUIRE(htable.emplace(key, std::move(other)) == -1);
+    REQUIRE(other == std::string(40, 'o'));
+
+    REQUIRE(htable.insert_or_assign(key, std::move(other)) >= 0);
+    REQUIRE(*htable.find(key) == std::string(40, 'o'));
+    REQUIRE(htable.insert_or_assign(std::string("new"), value) >= 0);
+    REQUIRE(htable.get_size() == 2);
+
+    *htable.find("new") = "changed";
+    REQUIRE(htable.get("new", value) >= 0);
+    REQUIRE(value == "changed");
+}
+
+/* Values that can only be moved, through blocking and incremental
+   resizes */
+template <typename HT>
+void move_only_test(HT &htable, bool incremental) {
+    int num_to_test = 10000;
+
+    htable.set_incremental_resize(incremental);
+
+    for (auto i=0; i<num_to_test; i++)
+        REQUIRE(htable.emplace(i, new int(i)) >= 0);
+    auto dup = std::make_unique<int>(-1);
+    REQUIRE(htable.emplace(0, std::move(dup)) == -1);
+    REQUIRE(dup != nullptr);
+
+    for (auto i=0; i<num_to_test; i+=2)
+        REQUIRE(htable.insert_or_assign(i, std::make_unique<int>(-i)) >= 0);
+    for (auto i=0; i<num_to_test; i+=4)
+        REQUIRE(htable.remove(i) >= 0);
+    htable.compact();
+
+    for (auto i=0; i<num_to_test; i++) {
+        if (i % 4 == 0) {
+            REQUIRE(htable.find(i) == nullptr);
+        } else {
+            REQUIRE(htable.find(i) != nullptr);
+            REQUIRE(**htable.find(i) == (i % 2 ? i : -i));
+        }
+    }
+}
+
+TEST_CASE("hashtable move semantics", "[hashtable]") {
+    LinearProbeHashTable<std::string, std::string, DefaultHash> linear_ht;
+    move_test(linear_ht);
+
+    QuadProbeHashTable<std::string, std::string, DefaultHash> quad_ht;
+    move_test(quad_ht);
+
+    for (bool incremental : { false, true }) {
+        LinearProbeHashTable<int, std::unique_ptr<int>, DefaultHash> linear_ptrs;
+        move_only_test(linear_ptrs, incremental);
+
+        QuadProbeHashTable<int, std::unique_ptr<int>, DefaultHash> quad_ptrs;
+        move_only_test(quad_ptrs, incremental);
+    }
+}
@@ -0,0 +1,48 @@
+#include <string>
+
+#include "robin_hood_table.hpp"
+#include "hash_funcs.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "table_test_util.hpp"
+
+#define RobinHoodIntStrHt RobinHoodHashTable<int, std::string, DefaultHash>
+
+TEST_CASE("robin hood simple test", "[robin_hood]") {
+    RobinHoodIntStrHt ht;
+    simple_test(ht);
+}
+
+TEST_CASE("robin hood enlarge", "[robin_hood]") {
+    RobinHoodIntStrHt ht;
+    enlarge_test(ht);
+}
+
+TEST_CASE("robin hood backward shift", "[robin_hood]") {
+    /* Every key in the same home slot, so that the probes count the keys
+       before it */
+    RobinHoodHashTable<int, std::string, ConstantHash> ht;
+    std::string value;
+
+    for (auto i=0; i<10; i++)
+        REQUIRE(ht.put(i, std::to_string(i)) == i);
+
+    /* The keys after 4 move one slot closer to home */
+    REQUIRE(ht.remove(4) == 4);
+    for (auto i=0; i<10; i++) {
+        if (i != 4)
+            REQUIRE(ht.get(i, value) == (i < 4 ? i : i - 1));
+    }
+
+    REQUIRE(ht.put(4, "4") == 9);
+}
+
+TEST_CASE("robin hood churn", "[robin_hood]") {
+    RobinHoodIntStrHt ht;
+    REQUIRE(churn_test(ht) < 32);
+
+    /* No tombstones: the table only grows with the live keys */
+    REQUIRE(ht.get_table_size() <= 8192);
+}
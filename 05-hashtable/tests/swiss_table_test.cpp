@@ -0,0 +1,58 @@
+#include <string>
+
+#include "swiss_table.hpp"
+#include "hash_funcs.hpp"
+
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
+
+#include "table_test_util.hpp"
+
+#define SwissIntStrHt SwissTable<int, std::string, DefaultHash>
+
+TEST_CASE("swiss table simple test", "[swiss_table]") {
+    SwissIntStrHt ht;
+    simple_test(ht);
+}
+
+TEST_CASE("swiss table enlarge", "[swiss_table]") {
+    SwissIntStrHt ht;
+    REQUIRE(ht.get_table_size() == SwissIntStrHt::INITIAL_SIZE);
+    enlarge_test(ht);
+}
+
+TEST_CASE("swiss table collisions", "[swiss_table]") {
+    /* Every key in the same home group, to exercise probing across
+       groups */
+    SwissTable<int, std::string, ConstantHash> ht;
+    int num_to_test = 1000;
+    std::string value;
+
+    /* The probes count groups: 16 keys per group, and the groups fill in
+       probing order until the table grows */
+    for (auto i=0; i<16; i++)
+        REQUIRE(ht.put(i, std::to_string(i)) == 0);
+    REQUIRE(ht.put(16, "16") == 1);
+
+    for (auto i=17; i<num_to_test; i++)
+        REQUIRE(ht.put(i, std::to_string(i)) >= 0);
+
+    for (auto i=0; i<num_to_test; i++) {
+        REQUIRE(ht.get(i, value) >= 0);
+        REQUIRE(value == std::to_string(i));
+    }
+
+    for (auto i=0; i<num_to_test; i+=2)
+        REQUIRE(ht.remove(i) >= 0);
+
+    for (auto i=0; i<num_to_test; i++)
+        REQUIRE((ht.get(i, value) >= 0) == (i % 2 == 1));
+}
+
+TEST_CASE("swiss table churn", "[swiss_table]") {
+    /* Steady size with many removals, so that tombstones pile up */
+    SwissIntStrHt ht;
+    churn_test(ht);
+
+    REQUIRE(ht.get_table_size() <= 16384);
+}
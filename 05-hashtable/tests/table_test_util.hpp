@@ -0,0 +1,100 @@
+#ifndef _TABLE_TEST_UTIL_HPP
+#define _TABLE_TEST_UTIL_HPP
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <unordered_map>
+
+#include <catch2/catch.hpp>
+
+/* The cases SwissTable and RobinHoodHashTable share. Both take int keys
+   and string values, and give put, get and remove the interface of
+   HashTable. */
+
+/* Every key in the same home slot, or group */
+struct ConstantHash {
+    unsigned long operator()(const int&) const {
+        return 0;
+    }
+};
+
+template <typename HT>
+void simple_test(HT &ht) {
+    std::string value;
+
+    REQUIRE(ht.put(1, "1") >= 0);
+    REQUIRE(ht.put(2, "2") >= 0);
+    REQUIRE(ht.put(3, "3") >= 0);
+    REQUIRE(ht.put(3, "4") == -1);
+
+    REQUIRE(ht.get(2, value) >= 0);
+    REQUIRE(value == "2");
+
+    REQUIRE(ht.get(3, value) >= 0);
+    REQUIRE(value == "3");
+
+    REQUIRE(ht.remove(3) >= 0);
+    REQUIRE(ht.get(3, value) == -1);
+    REQUIRE(ht.remove(3) == -1);
+    REQUIRE(ht.get_size() == 2);
+}
+
+template <typename HT>
+void enlarge_test(HT &ht) {
+    int num_to_test = 100000;
+    std::string value;
+
+    for (auto i=0; i<num_to_test; i++) {
+        REQUIRE(ht.put(i, std::to_string(i)) >= 0);
+        REQUIRE(ht.get_load_factor() <= 0.875);
+    }
+    REQUIRE(ht.get_size() == num_to_test);
+    REQUIRE(ht.get_load_factor() > 0.4);
+
+    for (auto i=0; i<num_to_test; i++) {
+        REQUIRE(ht.get(i, value) >= 0);
+        REQUIRE(value == std::to_string(i));
+    }
+    REQUIRE(ht.get(num_to_test, value) == -1);
+
+    for (auto i=0; i<num_to_test; i++) {
+        REQUIRE(ht.remove(i) >= 0);
+        REQUIRE(ht.get(i, value) == -1);
+    }
+    REQUIRE(ht.get_size() == 0);
+}
+
+/* Random puts and removes of 5001 keys against std::unordered_map, which
+   keep the size steady. Returns the most probes of a get. */
+template <typename HT>
+int churn_test(HT &ht) {
+    std::unordered_map<int, std::string> ref;
+    std::mt19937 g(0);
+    std::uniform_int_distribution<int> keys(0, 5000);
+    std::string value;
+
+    for (auto i=0; i<200000; i++) {
+        int k = keys(g);
+        if (g() % 2) {
+            bool inserted = ref.emplace(k, std::to_string(i)).second;
+            REQUIRE((ht.put(k, std::to_string(i)) >= 0) == inserted);
+        } else {
+            REQUIRE((ht.remove(k) >= 0) == (ref.erase(k) == 1));
+        }
+        REQUIRE(ht.get_size() == ref.size());
+    }
+
+    int max_probes = 0;
+    for (auto i=0; i<=5000; i++) {
+        auto it = ref.find(i);
+        int probes = ht.get(i, value);
+        REQUIRE((probes >= 0) == (it != ref.end()));
+        if (it != ref.end())
+            REQUIRE(value == it->second);
+        max_probes = std::max(max_probes, probes);
+    }
+    return max_probes;
+}
+
+#endif